@@ -69,8 +69,10 @@ static struct if_option_group local_option_group = {
 
 #ifdef CONFIG_YAML
 static void
-prettyprint_interface_yaml(struct lif_interface *iface)
+prettyprint_interface_yaml(struct lif_dict *collection, struct lif_interface *iface)
 {
+	(void) collection;
+
 	struct lif_yaml_node doc = {};
 
 	lif_yaml_document_init(&doc, "interfaces");
@@ -84,11 +86,11 @@ prettyprint_interface_yaml(struct lif_interface *iface)
 		lif_yaml_node_append_child(iface_node, iface_entry_node);
 	}
 
-	struct lif_node *iter;
-	LIF_DICT_FOREACH(iter, &iface->vars)
+	struct lif_interface_vars_iter iter;
+	struct lif_dict_entry *entry;
+	LIF_INTERFACE_VARS_FOREACH(entry, &iter, iface)
 	{
-		struct lif_dict_entry *entry = iter->data;
-		const char *value = entry->data;
+		const char *value = lif_value_text(entry);
 		char addr_buf[512];
 
 		if (!strcmp(entry->key, "address"))
@@ -112,7 +114,7 @@ prettyprint_interface_yaml(struct lif_interface *iface)
 
 struct prettyprint_impl_map {
 	const char *name;
-	void (*handle)(struct lif_interface *iface);
+	void (*handle)(struct lif_dict *collection, struct lif_interface *iface);
 };
 
 struct prettyprint_impl_map pp_impl_map[] = {
@@ -136,11 +138,6 @@ ifparse_main(int argc, char *argv[])
 {
 	struct lif_dict state = {};
 	struct lif_dict collection = {};
-	struct lif_interface_file_parse_state parse_state = {
-		.collection = &collection,
-	};
-
-	lif_interface_collection_init(&collection);
 
 	if (!lif_state_read_path(&state, exec_opts.state_file))
 	{
@@ -148,12 +145,18 @@ ifparse_main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	if (!lif_interface_file_parse(&parse_state, exec_opts.interfaces_file))
+	if (!lif_interface_file_load(&collection, exec_opts.interfaces_file, exec_opts.snapshot_file))
 	{
 		fprintf(stderr, "%s: could not parse %s\n", argv0, exec_opts.interfaces_file);
 		return EXIT_FAILURE;
 	}
 
+	if (show_all && !lif_interface_collection_expand_ranges(&collection))
+	{
+		fprintf(stderr, "%s: could not expand interface ranges\n", argv0);
+		return EXIT_FAILURE;
+	}
+
 	if (match_opts.property == NULL && lif_lifecycle_count_rdepends(&exec_opts, &collection) == -1)
 	{
 		fprintf(stderr, "%s: could not validate dependency tree\n", argv0);
@@ -181,7 +184,7 @@ ifparse_main(int argc, char *argv[])
 		{
 			struct lif_dict_entry *entry = n->data;
 
-			m->handle(entry->data);
+			m->handle(&collection, entry->data);
 		}
 
 		return EXIT_SUCCESS;
@@ -193,13 +196,9 @@ ifparse_main(int argc, char *argv[])
 	int idx = optind;
 	for (; idx < argc; idx++)
 	{
-		struct lif_dict_entry *entry = lif_dict_find(&collection, argv[idx]);
-		struct lif_interface *iface = NULL;
-
-		if (entry != NULL)
-			iface = entry->data;
+		struct lif_interface *iface = lif_interface_collection_lookup(&collection, argv[idx]);
 
-		if (entry == NULL && allow_undefined)
+		if (iface == NULL && allow_undefined)
 			iface = lif_interface_collection_find(&collection, argv[idx]);
 
 		if (iface == NULL)
@@ -208,7 +207,7 @@ ifparse_main(int argc, char *argv[])
 			return EXIT_FAILURE;
 		}
 
-		m->handle(iface);
+		m->handle(&collection, iface);
 	}
 
 	return EXIT_SUCCESS;
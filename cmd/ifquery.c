@@ -15,6 +15,7 @@
 
 #define _GNU_SOURCE
 #include <fnmatch.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include <getopt.h>
@@ -25,7 +26,7 @@
 static void
 print_interface_dot(struct lif_dict *collection, struct lif_interface *iface, struct lif_interface *parent)
 {
-	if (!lif_lifecycle_query_dependents(&exec_opts, iface, iface->ifname))
+	if (!lif_lifecycle_query_dependents(&exec_opts, collection, iface, iface->ifname))
 		return;
 
 	if (parent != NULL)
@@ -35,18 +36,12 @@ print_interface_dot(struct lif_dict *collection, struct lif_interface *iface, st
 
 	printf("\n");
 
-	struct lif_dict_entry *entry = lif_dict_find(&iface->vars, "requires");
-
-	if (entry == NULL)
+	if (!lif_interface_resolve_requires(collection, iface))
 		return;
 
-	char require_ifs[4096] = {};
-	strlcpy(require_ifs, entry->data, sizeof require_ifs);
-	char *reqp = require_ifs;
-
-	for (char *tokenp = lif_next_token(&reqp); *tokenp; tokenp = lif_next_token(&reqp))
+	for (size_t i = 0; i < iface->requires_count; i++)
 	{
-		struct lif_interface *child_if = lif_interface_collection_find(collection, tokenp);
+		struct lif_interface *child_if = iface->requires[i];
 
 		if (child_if->is_pending)
 			continue;
@@ -60,16 +55,12 @@ print_interface_dot(struct lif_dict *collection, struct lif_interface *iface, st
 static void
 print_interface_property(struct lif_interface *iface, const char *property)
 {
-	struct lif_node *iter;
+	struct lif_interface_vars_iter iter;
+	struct lif_dict_entry *entry;
 	bool printing_address = !strcmp(property, "address");
 
-	LIF_DICT_FOREACH(iter, &iface->vars)
+	LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, property)
 	{
-		struct lif_dict_entry *entry = iter->data;
-
-		if (strcmp(entry->key, property))
-			continue;
-
 		if (printing_address)
 		{
 			char addr_buf[512];
@@ -79,7 +70,7 @@ print_interface_property(struct lif_interface *iface, const char *property)
 			printf("%s\n", addr_buf);
 		}
 		else
-			printf("%s\n", (const char *) entry->data);
+			printf("%s\n", lif_value_text(entry));
 	}
 }
 
@@ -112,7 +103,7 @@ list_interfaces(struct lif_dict *collection, struct match_options *opts)
 			continue;
 
 		if (opts->pretty_print)
-			prettyprint_interface_eni(iface);
+			prettyprint_interface_eni(collection, iface);
 		else if (opts->dot)
 			print_interface_dot(collection, iface, NULL);
 		else
@@ -146,10 +137,18 @@ list_state(struct lif_dict *state, struct match_options *opts)
 		struct lif_state_record *rec = entry->data;
 
 		if (listing_running)
+		{
 			printf("%s\n", entry->key);
-		else
-			printf("%s=%s %zu%s\n", entry->key, rec->mapped_if, rec->refcount,
-			       rec->is_explicit ? " explicit" : "");
+			continue;
+		}
+
+		printf("%s=%s %zu%s", entry->key, rec->mapped_if, rec->refcount,
+		       rec->is_explicit ? " explicit" : "");
+
+		if (rec->fingerprint)
+			printf(" fingerprint=%016" PRIx64, rec->fingerprint);
+
+		printf("\n");
 	}
 }
 
@@ -222,11 +221,6 @@ ifquery_main(int argc, char *argv[])
 {
 	struct lif_dict state = {};
 	struct lif_dict collection = {};
-	struct lif_interface_file_parse_state parse_state = {
-		.collection = &collection,
-	};
-
-	lif_interface_collection_init(&collection);
 
 	if (!lif_state_read_path(&state, exec_opts.state_file))
 	{
@@ -234,12 +228,18 @@ ifquery_main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	if (!lif_interface_file_parse(&parse_state, exec_opts.interfaces_file))
+	if (!lif_interface_file_load(&collection, exec_opts.interfaces_file, exec_opts.snapshot_file))
 	{
 		fprintf(stderr, "%s: could not parse %s\n", argv0, exec_opts.interfaces_file);
 		return EXIT_FAILURE;
 	}
 
+	if (listing && !lif_interface_collection_expand_ranges(&collection))
+	{
+		fprintf(stderr, "%s: could not expand interface ranges\n", argv0);
+		return EXIT_FAILURE;
+	}
+
 	if (match_opts.property == NULL && lif_lifecycle_count_rdepends(&exec_opts, &collection) == -1)
 	{
 		fprintf(stderr, "%s: could not validate dependency tree\n", argv0);
@@ -277,12 +277,9 @@ ifquery_main(int argc, char *argv[])
 
 		if (iface == NULL)
 		{
-			struct lif_dict_entry *entry = lif_dict_find(&collection, argv[idx]);
-
-			if (entry != NULL)
-				iface = entry->data;
+			iface = lif_interface_collection_lookup(&collection, argv[idx]);
 
-			if (entry == NULL && allow_undefined)
+			if (iface == NULL && allow_undefined)
 				iface = lif_interface_collection_find(&collection, argv[idx]);
 		}
 
@@ -295,7 +292,7 @@ ifquery_main(int argc, char *argv[])
 		if (match_opts.property != NULL)
 			print_interface_property(iface, match_opts.property);
 		else
-			prettyprint_interface_eni(iface);
+			prettyprint_interface_eni(&collection, iface);
 	}
 
 	return EXIT_SUCCESS;
@@ -95,7 +95,7 @@ acquire_state_lock(const char *state_path, const char *lifname)
 }
 
 static bool
-skip_interface(struct lif_interface *iface, const char *ifname, struct lif_dict *state, bool update_state)
+skip_interface(struct lif_interface *iface, const char *ifname)
 {
 	if (iface->is_template)
 	{
@@ -122,16 +122,13 @@ skip_interface(struct lif_interface *iface, const char *ifname, struct lif_dict
 
 	if (up && iface->refcount > 0)
 	{
-		if (exec_opts.verbose)
+		if (iface->fingerprint && iface->fingerprint != lif_interface_fingerprint(iface))
+			fprintf(stderr, "%s: configuration of interface %s has changed since it was brought up, use ifreload to apply it\n",
+				argv0, ifname);
+		else if (exec_opts.verbose)
 			fprintf(stderr, "%s: skipping %sinterface %s (already configured), use --force to force configuration\n",
 				argv0, iface->is_auto ? "auto " : "", ifname);
 
-		if (update_state)
-		{
-			iface->is_explicit = true;
-			lif_state_upsert(state, ifname, iface);
-		}
-
 		return true;
 	}
 
@@ -146,6 +143,18 @@ skip_interface(struct lif_interface *iface, const char *ifname, struct lif_dict
 	return false;
 }
 
+static bool
+record_explicit(struct lif_interface *iface, struct lif_dict *state, const char *ifname)
+{
+	iface->is_explicit = true;
+
+	if (lif_state_upsert(state, ifname, iface))
+		return true;
+
+	fprintf(stderr, "%s: could not record interface %s in the state: %s\n", argv0, ifname, strerror(errno));
+	return false;
+}
+
 static bool
 change_interface(struct lif_interface *iface, struct lif_dict *collection, struct lif_dict *state, const char *ifname, bool update_state)
 {
@@ -157,11 +166,15 @@ change_interface(struct lif_interface *iface, struct lif_dict *collection, struc
 		return false;
 	}
 
-	if (skip_interface(iface, ifname, state, update_state))
+	if (skip_interface(iface, ifname))
 	{
 		if (lockfd != -1)
 			close(lockfd);
 
+		/* an interface which is already up is still marked as explicitly configured */
+		if (up && update_state && iface->refcount > 0 && !iface->has_config_error)
+			return record_explicit(iface, state, ifname);
+
 		return true;
 	}
 
@@ -186,10 +199,7 @@ change_interface(struct lif_interface *iface, struct lif_dict *collection, struc
 		close(lockfd);
 
 	if (up && update_state)
-	{
-		iface->is_explicit = true;
-		lif_state_upsert(state, ifname, iface);
-	}
+		return record_explicit(iface, state, ifname);
 
 	return true;
 }
@@ -254,11 +264,6 @@ ifupdown_main(int argc, char *argv[])
 
 	struct lif_dict state = {};
 	struct lif_dict collection = {};
-	struct lif_interface_file_parse_state parse_state = {
-		.collection = &collection,
-	};
-
-	lif_interface_collection_init(&collection);
 
 	if (!lif_state_read_path(&state, exec_opts.state_file))
 	{
@@ -266,13 +271,20 @@ ifupdown_main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	if (!lif_interface_file_parse(&parse_state, exec_opts.interfaces_file))
+	if (!lif_interface_file_load(&collection, exec_opts.interfaces_file, exec_opts.snapshot_file))
 	{
 		fprintf(stderr, "%s: could not parse %s\n", argv0, exec_opts.interfaces_file);
 		return EXIT_FAILURE;
 	}
 
-	if (lif_lifecycle_count_rdepends(&exec_opts, &collection) == -1)
+	/* expanding ranges and ordering the whole collection is only needed when walking all of it */
+	if (match_opts.is_auto && !lif_interface_collection_expand_ranges(&collection))
+	{
+		fprintf(stderr, "%s: could not expand interface ranges\n", argv0);
+		return EXIT_FAILURE;
+	}
+
+	if (match_opts.is_auto && lif_lifecycle_count_rdepends(&exec_opts, &collection) == -1)
 	{
 		fprintf(stderr, "%s: could not validate dependency tree\n", argv0);
 		return EXIT_FAILURE;
@@ -300,43 +312,296 @@ ifupdown_main(int argc, char *argv[])
 	else if (optind >= argc)
 		generic_usage(self_applet, EXIT_FAILURE);
 
-	int idx = optind;
-	for (; idx < argc; idx++)
+	size_t count = argc - optind;
+	struct lif_interface **ifaces = calloc(count, sizeof *ifaces);
+	char (*ifnames)[4096] = calloc(count, sizeof *ifnames);
+
+	if (ifaces == NULL || ifnames == NULL)
 	{
-		char lifbuf[4096];
-		strlcpy(lifbuf, argv[idx], sizeof lifbuf);
+		fprintf(stderr, "%s: %s\n", argv0, strerror(errno));
+		return EXIT_FAILURE;
+	}
 
-		char *ifname = lifbuf;
-		char *lifname = lifbuf;
+	for (size_t i = 0; i < count; i++)
+	{
+		const char *arg = argv[optind + i];
+		char *lifname = ifnames[i];
 		char *p;
 
-		if ((p = strchr(lifbuf, '=')) != NULL)
+		strlcpy(ifnames[i], arg, sizeof ifnames[i]);
+
+		if ((p = strchr(ifnames[i], '=')) != NULL)
 		{
 			*p++ = '\0';
 			lifname = p;
 		}
 
-		struct lif_interface *iface = lif_state_lookup(&state, &collection, argv[idx]);
-		if (iface == NULL)
+		ifaces[i] = lif_state_lookup(&state, &collection, arg);
+		if (ifaces[i] == NULL)
 		{
-			struct lif_dict_entry *entry = lif_dict_find(&collection, lifname);
-
-			if (entry == NULL)
+			ifaces[i] = lif_interface_collection_lookup(&collection, lifname);
+			if (ifaces[i] == NULL)
 			{
-				fprintf(stderr, "%s: unknown interface %s\n", argv0, argv[idx]);
+				fprintf(stderr, "%s: unknown interface %s\n", argv0, arg);
 				return update_state_file_and_exit(EXIT_FAILURE, &state);
 			}
-
-			iface = entry->data;
 		}
+	}
+
+	/* only learn the dependencies of the interfaces we were asked to change */
+	if (!lif_lifecycle_resolve_closure(&exec_opts, &collection, ifaces, count))
+	{
+		fprintf(stderr, "%s: could not validate dependency tree\n", argv0);
+		return update_state_file_and_exit(EXIT_FAILURE, &state);
+	}
 
-		if (!change_interface(iface, &collection, &state, ifname, true))
+	for (size_t i = 0; i < count; i++)
+	{
+		if (!change_interface(ifaces[i], &collection, &state, ifnames[i], true))
 			return update_state_file_and_exit(EXIT_FAILURE, &state);
 	}
 
 	return update_state_file_and_exit(EXIT_SUCCESS, &state);
 }
 
+/*
+ * ifreload compares the fingerprint recorded in the state file for each
+ * running interface with the fingerprint of its current configuration,
+ * and only cycles interfaces which were added, removed or changed, along
+ * with any running interfaces depending on them.
+ */
+struct reload_record {
+	struct lif_interface *iface;
+	bool removed;
+	bool was_explicit;
+};
+
+static bool
+reload_requires_marked(struct lif_interface *iface, struct lif_dict *reload)
+{
+	for (size_t i = 0; i < iface->requires_count; i++)
+	{
+		if (lif_dict_find(reload, iface->requires[i]->ifname) != NULL)
+			return true;
+	}
+
+	return false;
+}
+
+static bool
+reload_mark(struct lif_dict *reload, const char *ifname, struct lif_interface *iface, bool removed, const char *reason)
+{
+	struct reload_record *rec = calloc(1, sizeof *rec);
+
+	if (rec == NULL || lif_dict_add(reload, ifname, rec) == NULL)
+	{
+		fprintf(stderr, "%s: %s: out of memory\n", argv0, ifname);
+		free(rec);
+		return false;
+	}
+
+	rec->iface = iface;
+	rec->removed = removed;
+	rec->was_explicit = iface->is_explicit;
+
+	if (exec_opts.verbose)
+		fprintf(stderr, "%s: %s: %s\n", argv0, ifname, reason);
+
+	return true;
+}
+
+static void
+reload_fini(struct lif_dict *reload)
+{
+	struct lif_node *iter;
+
+	LIF_DICT_FOREACH(iter, reload)
+	{
+		struct lif_dict_entry *entry = iter->data;
+
+		free(entry->data);
+	}
+
+	lif_dict_fini(reload);
+}
+
+static bool
+reload_match(struct lif_interface *iface, struct match_options *opts)
+{
+	if (opts->exclude_pattern != NULL &&
+	    !fnmatch(opts->exclude_pattern, iface->ifname, 0))
+		return false;
+
+	if (opts->include_pattern != NULL &&
+	    fnmatch(opts->include_pattern, iface->ifname, 0))
+		return false;
+
+	return true;
+}
+
+static int
+ifreload_main(int argc, char *argv[])
+{
+	(void) argc;
+	(void) argv;
+
+	struct lif_dict state = {};
+	struct lif_dict collection = {};
+	struct lif_dict reload = {};
+	struct lif_node *iter;
+	bool ret = true;
+
+	if (!lif_state_read_path(&state, exec_opts.state_file))
+	{
+		fprintf(stderr, "%s: could not parse %s\n", argv0, exec_opts.state_file);
+		return EXIT_FAILURE;
+	}
+
+	if (!lif_interface_file_load(&collection, exec_opts.interfaces_file, exec_opts.snapshot_file))
+	{
+		fprintf(stderr, "%s: could not parse %s\n", argv0, exec_opts.interfaces_file);
+		return EXIT_FAILURE;
+	}
+
+	if (!lif_interface_collection_expand_ranges(&collection))
+	{
+		fprintf(stderr, "%s: could not expand interface ranges\n", argv0);
+		return EXIT_FAILURE;
+	}
+
+	if (lif_lifecycle_count_rdepends(&exec_opts, &collection) == -1)
+	{
+		fprintf(stderr, "%s: could not validate dependency tree\n", argv0);
+		return EXIT_FAILURE;
+	}
+
+	if (!lif_compat_apply(&collection))
+	{
+		fprintf(stderr, "%s: failed to apply compatibility glue\n", argv0);
+		return EXIT_FAILURE;
+	}
+
+	/* interfaces which are running but no longer configured: syncing the
+	 * state creates placeholders for them, so look for them first.
+	 */
+	struct lif_dict removed = {};
+
+	LIF_DICT_FOREACH(iter, &state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (lif_dict_find(&collection, rec->mapped_if) == NULL)
+			lif_dict_add(&removed, entry->key, NULL);
+	}
+
+	if (!lif_state_sync(&state, &collection))
+	{
+		fprintf(stderr, "%s: could not sync state\n", argv0);
+		return EXIT_FAILURE;
+	}
+
+	LIF_DICT_FOREACH(iter, &state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_interface *iface = lif_state_lookup(&state, &collection, entry->key);
+
+		if (iface == NULL || !reload_match(iface, &match_opts))
+			continue;
+
+		if (lif_dict_find(&removed, entry->key) != NULL)
+			ret = reload_mark(&reload, entry->key, iface, true, "no longer configured");
+		else if (iface->fingerprint && iface->fingerprint != lif_interface_fingerprint(iface))
+			ret = reload_mark(&reload, entry->key, iface, false, "configuration changed");
+
+		if (!ret)
+			break;
+	}
+
+	lif_dict_fini(&removed);
+
+	/* running interfaces which depend on a reloaded interface are reloaded too */
+	for (bool marked = true; marked && ret;)
+	{
+		marked = false;
+
+		LIF_DICT_FOREACH(iter, &collection)
+		{
+			struct lif_dict_entry *entry = iter->data;
+			struct lif_interface *iface = entry->data;
+
+			if (!iface->refcount || lif_dict_find(&reload, iface->ifname) != NULL)
+				continue;
+
+			if (!reload_requires_marked(iface, &reload))
+				continue;
+
+			if (!reload_mark(&reload, iface->ifname, iface, false, "dependency changed"))
+			{
+				ret = false;
+				break;
+			}
+
+			marked = true;
+		}
+	}
+
+	/* nothing has been changed yet, so give up without touching the state */
+	if (!ret)
+	{
+		reload_fini(&reload);
+		return EXIT_FAILURE;
+	}
+
+	/* the collection is ordered with dependents first, so take them down first */
+	up = false;
+
+	LIF_DICT_FOREACH(iter, &collection)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_interface *iface = entry->data;
+
+		if (lif_dict_find(&reload, iface->ifname) == NULL)
+			continue;
+
+		if (!change_interface(iface, &collection, &state, iface->ifname, false))
+			ret = false;
+	}
+
+	/* and bring everything back up in the opposite order, together with new auto interfaces */
+	up = true;
+
+	LIF_DICT_FOREACH_REVERSE(iter, &collection)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_interface *iface = entry->data;
+		struct lif_dict_entry *reload_entry = lif_dict_find(&reload, iface->ifname);
+		bool update_state = false;
+
+		if (reload_entry != NULL)
+		{
+			struct reload_record *rec = reload_entry->data;
+
+			/* interfaces which were only up as a dependency come back with their dependents */
+			if (rec->removed || !rec->was_explicit)
+				continue;
+
+			update_state = true;
+		}
+		else if (!iface->is_auto || iface->is_template || iface->refcount || !reload_match(iface, &match_opts))
+			continue;
+		else if (exec_opts.verbose)
+			fprintf(stderr, "%s: %s: newly configured\n", argv0, iface->ifname);
+
+		if (!change_interface(iface, &collection, &state, iface->ifname, update_state))
+			ret = false;
+	}
+
+	reload_fini(&reload);
+
+	return update_state_file_and_exit(ret ? EXIT_SUCCESS : EXIT_FAILURE, &state);
+}
+
 struct if_applet ifup_applet = {
 	.name = "ifup",
 	.desc = "bring interfaces up",
@@ -356,3 +621,13 @@ struct if_applet ifdown_applet = {
 	.groups = { &global_option_group, &match_option_group, &exec_option_group, },
 };
 APPLET_REGISTER(ifdown_applet)
+
+struct if_applet ifreload_applet = {
+	.name = "ifreload",
+	.desc = "apply configuration changes to running interfaces",
+	.main = ifreload_main,
+	.usage = "ifreload [options]",
+	.manpage = "8 ifreload",
+	.groups = { &global_option_group, &match_option_group, &exec_option_group, },
+};
+APPLET_REGISTER(ifreload_applet)
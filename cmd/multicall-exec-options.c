@@ -27,6 +27,7 @@ struct lif_execute_opts exec_opts = {
 	.interfaces_file = INTERFACES_FILE,
 	.executor_path = EXECUTOR_PATH,
 	.state_file = STATE_FILE,
+	.snapshot_file = SNAPSHOT_FILE,
 	.timeout = DEFAULT_TIMEOUT,
 };
 
@@ -42,6 +43,12 @@ set_state_file(const char *opt_arg)
 	exec_opts.state_file = opt_arg;
 }
 
+static void
+set_snapshot_file(const char *opt_arg)
+{
+	exec_opts.snapshot_file = opt_arg;
+}
+
 static void
 set_no_act(const char *opt_arg)
 {
@@ -91,6 +98,7 @@ static struct if_option exec_options[] = {
 	{'l', "no-lock", NULL, "do not use a lockfile to serialize state changes", false, set_no_lock},
 	{'n', "no-act", NULL, "do not actually run any commands", false, set_no_act},
 	{'v', "verbose", NULL, "show what commands are being run", false, set_verbose},
+	{'C', "snapshot-file", "snapshot-file FILE", "use FILE to cache the parsed interfaces file, or none if empty", true, set_snapshot_file},
 	{'E', "executor-path", "executor-path PATH", "use PATH for executor directory", true, set_executor_path},
 	{'S', "state-file", "state-file FILE", "use FILE for state", true, set_state_file},
 	{'T', "timeout", "timeout TIMEOUT", "wait TIMEOUT seconds for executors to complete", true, set_timeout},
@@ -67,7 +67,13 @@ main(int argc, char *argv[])
 	argv0 = basename(argv[0]);
 	const struct if_applet **app;
 
-	lif_config_load(CONFIG_FILE);
+	const char *config_file = getenv("IFUPDOWN_NG_CONFIG");
+	lif_config_load(config_file != NULL ? config_file : CONFIG_FILE);
+
+	/* the snapshot can be moved or disabled for a whole tree of commands, e.g. by the test suite */
+	const char *snapshot_file = getenv("IFUPDOWN_NG_SNAPSHOT_FILE");
+	if (snapshot_file != NULL)
+		exec_opts.snapshot_file = snapshot_file;
 
 	app = bsearch(argv0, applet_table,
 		      applet_count, sizeof (void *),
@@ -20,9 +20,9 @@
 #include "cmd/pretty-print-iface.h"
 
 void
-prettyprint_interface_eni(struct lif_interface *iface)
+prettyprint_interface_eni(struct lif_dict *collection, struct lif_interface *iface)
 {
-	if (!lif_lifecycle_query_dependents(&exec_opts, iface, iface->ifname))
+	if (!lif_lifecycle_query_dependents(&exec_opts, collection, iface, iface->ifname))
 		return;
 
 	if (iface->is_auto)
@@ -35,11 +35,10 @@ prettyprint_interface_eni(struct lif_interface *iface)
 
 	printf("\n");
 
-	struct lif_node *iter;
-	LIF_DICT_FOREACH(iter, &iface->vars)
+	struct lif_interface_vars_iter iter;
+	struct lif_dict_entry *entry;
+	LIF_INTERFACE_VARS_FOREACH(entry, &iter, iface)
 	{
-		struct lif_dict_entry *entry = iter->data;
-
 		if (!strcmp(entry->key, "address"))
 		{
 			struct lif_address *addr = entry->data;
@@ -54,7 +53,7 @@ prettyprint_interface_eni(struct lif_interface *iface)
 			printf("  %s %s\n", entry->key, addr_buf);
 		}
 		else
-			printf("  %s %s\n", entry->key, (const char *) entry->data);
+			printf("  %s %s\n", entry->key, lif_value_text(entry));
 	}
 
 	printf("\n");
@@ -18,6 +18,6 @@
 
 #include "libifupdown/libifupdown.h"
 
-extern void prettyprint_interface_eni(struct lif_interface *iface);
+extern void prettyprint_interface_eni(struct lif_dict *collection, struct lif_interface *iface);
 
 #endif
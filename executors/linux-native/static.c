@@ -0,0 +1,930 @@
+/*
+ * executors/linux-native/static.c
+ * Purpose: converge static addresses and gateways using rtnetlink
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+/*
+ * Unlike the shell executor, which flushes every address on down and
+ * blindly re-adds everything on up, this executor diffs the desired
+ * addresses and default gateways against what the kernel currently has
+ * and only applies the difference, in a single netlink batch.  Applying
+ * an unchanged configuration again therefore does not touch the kernel.
+ *
+ * Addresses and routes we install are tagged with LIF_RTPROT, so that
+ * ones which have since been removed from the configuration can be told
+ * apart from ones added by other daemons, which are left alone.
+ *
+ * If MOCK is set, the kernel is not touched: its addresses and routes
+ * are read from the file named by MOCK_DUMP instead, one per line in
+ * the form "address ADDR/PREFIX [peer PEER] [proto N]" or "gateway GW
+ * [table N] [metric N] [proto N]", and the requests which would have
+ * been sent are printed.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <net/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+#include <linux/if_link.h>
+#include "libifupdown-executor/executor.h"
+#include "libifupdown/netlink.h"
+
+/* protocol tag for addresses and routes installed by ifupdown-ng */
+#define LIF_RTPROT		0x69
+
+#ifndef IFA_PROTO
+# define IFA_PROTO		11
+#endif
+
+#define DEFAULT_METRIC		1
+
+/* interface index used for the interface and its kernel state when mocking */
+#define MOCK_IFINDEX		2
+
+struct static_address {
+	int family;
+	unsigned char prefixlen;
+	unsigned char local[16];
+	unsigned char peer[16];
+	bool has_peer;
+	bool present;
+};
+
+struct static_route {
+	int family;
+	unsigned char gateway[16];
+	bool present;
+};
+
+struct static_config {
+	const char *ifname;
+	unsigned int ifindex;
+	unsigned int table;
+	unsigned int metric;
+	bool optimistic;
+
+	struct static_address *addresses;
+	size_t address_count;
+
+	struct static_route *routes;
+	size_t route_count;
+
+	struct lif_netlink_batch batch;
+	bool verbose;
+	bool failed;
+
+	/* recorded kernel state, replayed instead of dumping it when mocking */
+	struct lif_netlink_batch kernel;
+	bool mock;
+};
+
+static size_t
+family_addrlen(int family)
+{
+	return family == AF_INET6 ? 16 : 4;
+}
+
+static const char *
+iface_var(struct lif_interface *iface, const char *key)
+{
+	struct lif_dict_entry *entry = lif_interface_find_var(iface, key);
+
+	return entry != NULL ? entry->data : NULL;
+}
+
+static const struct lif_value *
+iface_value(struct lif_interface *iface, const char *key, enum lif_value_type type)
+{
+	return lif_value_get(lif_interface_find_var(iface, key), type);
+}
+
+static void
+format_address(int family, const void *addr, unsigned char prefixlen, char *buf, size_t buflen)
+{
+	char addrbuf[INET6_ADDRSTRLEN] = "?";
+
+	inet_ntop(family, addr, addrbuf, sizeof addrbuf);
+
+	if (prefixlen)
+		snprintf(buf, buflen, "%s/%u", addrbuf, prefixlen);
+	else
+		strlcpy(buf, addrbuf, buflen);
+}
+
+static bool
+kernel_dump(struct static_config *cfg, struct lif_netlink *nl, int type, const void *payload, size_t payload_len, lif_netlink_msg_fn fn, void *ctx)
+{
+	if (!cfg->mock)
+		return lif_netlink_dump(nl, type, payload, payload_len, fn, ctx);
+
+	lif_netlink_batch_foreach(&cfg->kernel, fn, ctx);
+	return true;
+}
+
+/*
+ * VRF member interfaces have their routes installed into the table of
+ * the VRF device, which is found in its link info.
+ */
+struct vrf_lookup {
+	const char *ifname;
+	unsigned int table;
+};
+
+static void
+vrf_lookup_link(struct nlmsghdr *nlh, void *ctx)
+{
+	struct vrf_lookup *lookup = ctx;
+	struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+	int attrlen = IFLA_PAYLOAD(nlh);
+	struct rtattr *linkinfo = NULL;
+	const char *ifname = NULL;
+
+	if (nlh->nlmsg_type != RTM_NEWLINK)
+		return;
+
+	for (struct rtattr *rta = IFLA_RTA(ifi); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+	{
+		if (rta->rta_type == IFLA_IFNAME)
+			ifname = RTA_DATA(rta);
+		else if (rta->rta_type == IFLA_LINKINFO)
+			linkinfo = rta;
+	}
+
+	if (ifname == NULL || linkinfo == NULL || strcmp(ifname, lookup->ifname))
+		return;
+
+	attrlen = RTA_PAYLOAD(linkinfo);
+	for (struct rtattr *rta = RTA_DATA(linkinfo); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+	{
+		if (rta->rta_type != IFLA_INFO_DATA)
+			continue;
+
+		int datalen = RTA_PAYLOAD(rta);
+		for (struct rtattr *data = RTA_DATA(rta); RTA_OK(data, datalen); data = RTA_NEXT(data, datalen))
+		{
+			if (data->rta_type == IFLA_VRF_TABLE)
+				lookup->table = *(uint32_t *) RTA_DATA(data);
+		}
+	}
+}
+
+static bool
+load_config(struct lif_interface *iface, struct lif_netlink *nl, struct static_config *cfg)
+{
+	struct lif_interface_vars_iter iter;
+	struct lif_dict_entry *entry;
+	const struct lif_value *typed;
+	const char *value;
+
+	cfg->ifname = iface->ifname;
+	cfg->ifindex = cfg->mock ? MOCK_IFINDEX : if_nametoindex(iface->ifname);
+	cfg->table = RT_TABLE_MAIN;
+	cfg->metric = DEFAULT_METRIC;
+	cfg->optimistic = (typed = iface_value(iface, "ipv6-optimistic-dad", LIF_VALUE_BOOL)) != NULL && typed->boolean;
+	cfg->verbose = getenv("VERBOSE") != NULL;
+
+	if (cfg->ifindex == 0)
+	{
+		fprintf(stderr, "static: %s: %s\n", iface->ifname, strerror(errno));
+		return false;
+	}
+
+	if ((typed = iface_value(iface, "metric", LIF_VALUE_INTEGER)) != NULL)
+		cfg->metric = typed->integer;
+
+	if ((typed = iface_value(iface, "vrf-table", LIF_VALUE_INTEGER)) != NULL)
+		cfg->table = typed->integer;
+
+	if ((value = iface_var(iface, "vrf-member")) != NULL)
+	{
+		struct vrf_lookup lookup = {
+			.ifname = value,
+		};
+		struct ifinfomsg ifi = {
+			.ifi_family = AF_UNSPEC,
+		};
+
+		if (!kernel_dump(cfg, nl, RTM_GETLINK, &ifi, sizeof ifi, vrf_lookup_link, &lookup))
+		{
+			fprintf(stderr, "static: %s: could not look up VRF %s: %s\n", iface->ifname, value, strerror(errno));
+			return false;
+		}
+
+		if (!lookup.table)
+		{
+			fprintf(stderr, "static: %s: VRF %s does not exist\n", iface->ifname, value);
+			return false;
+		}
+
+		cfg->table = lookup.table;
+	}
+
+	const char *peer = iface_var(iface, "point-to-point");
+
+	LIF_INTERFACE_VARS_FOREACH(entry, &iter, iface)
+	{
+		if (!strcmp(entry->key, "address"))
+		{
+			struct static_address *addr;
+			struct lif_address parsed;
+			char addrbuf[512];
+
+			/* fill in the default netmask for the interface, the same way the shell executor sees it */
+			if (!lif_address_format_cidr(iface, entry, addrbuf, sizeof addrbuf) ||
+			    !lif_address_parse(&parsed, addrbuf))
+				continue;
+
+			addr = realloc(cfg->addresses, (cfg->address_count + 1) * sizeof *addr);
+			if (addr == NULL)
+				return false;
+
+			cfg->addresses = addr;
+			addr = &cfg->addresses[cfg->address_count++];
+			memset(addr, 0, sizeof *addr);
+
+			addr->family = parsed.domain;
+			addr->prefixlen = parsed.netmask;
+			memcpy(addr->local, parsed.addr_buf, family_addrlen(addr->family));
+
+			if (peer != NULL && addr->family == AF_INET && inet_pton(AF_INET, peer, addr->peer) == 1)
+				addr->has_peer = true;
+		}
+		else if (!strcmp(entry->key, "gateway"))
+		{
+			struct static_route *route;
+			int family = strchr(entry->data, ':') != NULL ? AF_INET6 : AF_INET;
+
+			route = realloc(cfg->routes, (cfg->route_count + 1) * sizeof *route);
+			if (route == NULL)
+				return false;
+
+			cfg->routes = route;
+			route = &cfg->routes[cfg->route_count];
+			memset(route, 0, sizeof *route);
+
+			if (inet_pton(family, entry->data, route->gateway) != 1)
+			{
+				fprintf(stderr, "static: %s: ignoring invalid gateway %s\n", iface->ifname, (const char *) entry->data);
+				continue;
+			}
+
+			route->family = family;
+			cfg->route_count++;
+		}
+	}
+
+	return true;
+}
+
+static void
+free_config(struct static_config *cfg)
+{
+	free(cfg->addresses);
+	free(cfg->routes);
+	lif_netlink_batch_fini(&cfg->batch);
+	lif_netlink_batch_fini(&cfg->kernel);
+}
+
+static bool
+queue_address(struct static_config *cfg, int type, int family, unsigned char prefixlen, const void *local, const void *address, bool tag)
+{
+	size_t addrlen = family_addrlen(family);
+	struct ifaddrmsg ifa = {
+		.ifa_family = family,
+		.ifa_prefixlen = prefixlen,
+		.ifa_scope = RT_SCOPE_UNIVERSE,
+		.ifa_index = cfg->ifindex,
+	};
+
+	if (cfg->verbose)
+	{
+		char buf[INET6_ADDRSTRLEN + 4];
+
+		format_address(family, local, prefixlen, buf, sizeof buf);
+		fprintf(stderr, "static: %s: %s address %s\n", cfg->ifname,
+			type == RTM_NEWADDR ? "adding" : "removing", buf);
+	}
+
+	if (!lif_netlink_batch_add(&cfg->batch, type, type == RTM_NEWADDR ? NLM_F_CREATE | NLM_F_EXCL : 0, &ifa, sizeof ifa))
+		return false;
+
+	if (!lif_netlink_batch_add_attr(&cfg->batch, IFA_LOCAL, local, addrlen))
+		return false;
+
+	if (!lif_netlink_batch_add_attr(&cfg->batch, IFA_ADDRESS, address, addrlen))
+		return false;
+
+	if (type != RTM_NEWADDR)
+		return true;
+
+	if (family == AF_INET6 && cfg->optimistic)
+	{
+		uint32_t flags = IFA_F_OPTIMISTIC;
+
+		if (!lif_netlink_batch_add_attr(&cfg->batch, IFA_FLAGS, &flags, sizeof flags))
+			return false;
+	}
+
+	if (tag)
+	{
+		uint8_t proto = LIF_RTPROT;
+
+		if (!lif_netlink_batch_add_attr(&cfg->batch, IFA_PROTO, &proto, sizeof proto))
+			return false;
+	}
+
+	return true;
+}
+
+static bool
+queue_route(struct static_config *cfg, int type, int family, const void *gateway, unsigned int table, unsigned int metric)
+{
+	uint32_t oif = cfg->ifindex;
+	struct rtmsg rtm = {
+		.rtm_family = family,
+		.rtm_table = table < 256 ? table : RT_TABLE_UNSPEC,
+		.rtm_protocol = LIF_RTPROT,
+		.rtm_scope = RT_SCOPE_UNIVERSE,
+		.rtm_type = RTN_UNICAST,
+		.rtm_flags = RTNH_F_ONLINK,
+	};
+
+	if (cfg->verbose)
+	{
+		char buf[INET6_ADDRSTRLEN];
+
+		format_address(family, gateway, 0, buf, sizeof buf);
+		fprintf(stderr, "static: %s: %s default route via %s\n", cfg->ifname,
+			type == RTM_NEWROUTE ? "adding" : "removing", buf);
+	}
+
+	if (!lif_netlink_batch_add(&cfg->batch, type, type == RTM_NEWROUTE ? NLM_F_CREATE | NLM_F_EXCL : 0, &rtm, sizeof rtm))
+		return false;
+
+	if (!lif_netlink_batch_add_attr(&cfg->batch, RTA_GATEWAY, gateway, family_addrlen(family)))
+		return false;
+
+	if (!lif_netlink_batch_add_attr(&cfg->batch, RTA_OIF, &oif, sizeof oif))
+		return false;
+
+	if (!lif_netlink_batch_add_attr(&cfg->batch, RTA_PRIORITY, &metric, sizeof metric))
+		return false;
+
+	return lif_netlink_batch_add_attr(&cfg->batch, RTA_TABLE, &table, sizeof table);
+}
+
+/*
+ * Walk the kernel's addresses on the interface: mark the configured
+ * ones as present, and queue removal of stale ones.  When going down,
+ * every configured or previously tagged address is removed.
+ */
+struct address_walk {
+	struct static_config *cfg;
+	bool up;
+};
+
+static void
+address_walk(struct nlmsghdr *nlh, void *ctx)
+{
+	struct address_walk *walk = ctx;
+	struct static_config *cfg = walk->cfg;
+	struct ifaddrmsg *ifa = NLMSG_DATA(nlh);
+	int attrlen = IFA_PAYLOAD(nlh);
+	const unsigned char *local = NULL, *address = NULL;
+	uint8_t proto = 0;
+
+	if (nlh->nlmsg_type != RTM_NEWADDR || ifa->ifa_index != cfg->ifindex)
+		return;
+
+	if (ifa->ifa_family != AF_INET && ifa->ifa_family != AF_INET6)
+		return;
+
+	for (struct rtattr *rta = IFA_RTA(ifa); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+	{
+		if (rta->rta_type == IFA_LOCAL)
+			local = RTA_DATA(rta);
+		else if (rta->rta_type == IFA_ADDRESS)
+			address = RTA_DATA(rta);
+		else if (rta->rta_type == IFA_PROTO)
+			proto = *(uint8_t *) RTA_DATA(rta);
+	}
+
+	if (address == NULL)
+		return;
+
+	if (local == NULL)
+		local = address;
+
+	size_t addrlen = family_addrlen(ifa->ifa_family);
+	bool configured = false, stale = proto == LIF_RTPROT, replaced = false;
+
+	for (size_t i = 0; i < cfg->address_count; i++)
+	{
+		struct static_address *addr = &cfg->addresses[i];
+
+		if (addr->family != ifa->ifa_family || memcmp(addr->local, local, addrlen))
+			continue;
+
+		/*
+		 * the same address with a different prefix or peer has been
+		 * reconfigured: it is only stale if we installed it, otherwise
+		 * it belongs to someone else and is left alone.  IPv6 addresses
+		 * are keyed by the address alone though, so the configured one
+		 * can only be added in place of the one which is there.
+		 */
+		if (addr->prefixlen != ifa->ifa_prefixlen ||
+		    memcmp(addr->has_peer ? addr->peer : addr->local, address, addrlen))
+		{
+			if (ifa->ifa_family == AF_INET6)
+				replaced = true;
+
+			continue;
+		}
+
+		addr->present = true;
+		configured = true;
+	}
+
+	if (walk->up ? ((stale || replaced) && !configured) : (stale || configured))
+	{
+		if (!queue_address(cfg, RTM_DELADDR, ifa->ifa_family, ifa->ifa_prefixlen, local, address, false))
+			cfg->failed = true;
+	}
+}
+
+struct route_walk {
+	struct static_config *cfg;
+	bool up;
+};
+
+static void
+route_walk(struct nlmsghdr *nlh, void *ctx)
+{
+	struct route_walk *walk = ctx;
+	struct static_config *cfg = walk->cfg;
+	struct rtmsg *rtm = NLMSG_DATA(nlh);
+	int attrlen = RTM_PAYLOAD(nlh);
+	const unsigned char *gateway = NULL;
+	uint32_t oif = 0, table = rtm->rtm_table, metric = 0;
+
+	if (nlh->nlmsg_type != RTM_NEWROUTE || rtm->rtm_dst_len != 0 || rtm->rtm_type != RTN_UNICAST)
+		return;
+
+	for (struct rtattr *rta = RTM_RTA(rtm); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+	{
+		if (rta->rta_type == RTA_GATEWAY)
+			gateway = RTA_DATA(rta);
+		else if (rta->rta_type == RTA_OIF)
+			oif = *(uint32_t *) RTA_DATA(rta);
+		else if (rta->rta_type == RTA_TABLE)
+			table = *(uint32_t *) RTA_DATA(rta);
+		else if (rta->rta_type == RTA_PRIORITY)
+			metric = *(uint32_t *) RTA_DATA(rta);
+	}
+
+	if (gateway == NULL || oif != cfg->ifindex)
+		return;
+
+	bool configured = false, stale = rtm->rtm_protocol == LIF_RTPROT;
+
+	if (table == cfg->table && metric == cfg->metric)
+	{
+		for (size_t i = 0; i < cfg->route_count; i++)
+		{
+			struct static_route *route = &cfg->routes[i];
+
+			if (route->family != rtm->rtm_family || memcmp(route->gateway, gateway, family_addrlen(route->family)))
+				continue;
+
+			route->present = true;
+			configured = true;
+		}
+	}
+
+	if (walk->up ? (stale && !configured) : (stale || configured))
+	{
+		if (!queue_route(cfg, RTM_DELROUTE, rtm->rtm_family, gateway, table, metric))
+			cfg->failed = true;
+	}
+}
+
+static bool
+batch_error(const struct nlmsghdr *req, int error, void *ctx)
+{
+	struct static_config *cfg = ctx;
+
+	/*
+	 * someone else got there first, which is the state we want.  this
+	 * does not hold for addresses, which only clash on part of what is
+	 * configured, such as an IPv6 address with another prefix: any that
+	 * match exactly were seen in the dump and are not added again.
+	 */
+	if (req->nlmsg_type == RTM_NEWROUTE && error == EEXIST)
+		return true;
+
+	if ((req->nlmsg_type == RTM_DELADDR || req->nlmsg_type == RTM_DELROUTE) &&
+	    (error == ESRCH || error == ENOENT || error == EADDRNOTAVAIL))
+		return true;
+
+	const char *action;
+	switch (req->nlmsg_type)
+	{
+	case RTM_NEWADDR:
+		action = "add address";
+		break;
+	case RTM_DELADDR:
+		action = "remove address";
+		break;
+	case RTM_NEWROUTE:
+		action = "add default route";
+		break;
+	default:
+		action = "remove default route";
+		break;
+	}
+
+	fprintf(stderr, "static: %s: failed to %s: %s\n", cfg->ifname, action, strerror(error));
+	return false;
+}
+
+static bool
+mock_parse_number(const char *ifname, const char *key, const char *value, unsigned int *out)
+{
+	char *end;
+
+	if (value == NULL)
+	{
+		fprintf(stderr, "static: %s: mock %s requires a value\n", ifname, key);
+		return false;
+	}
+
+	unsigned long number = strtoul(value, &end, 0);
+	if (*end != '\0' || number > UINT32_MAX)
+	{
+		fprintf(stderr, "static: %s: invalid mock %s %s\n", ifname, key, value);
+		return false;
+	}
+
+	*out = number;
+	return true;
+}
+
+static bool
+mock_add_address(struct static_config *cfg, char *addrstr, char **saveptr)
+{
+	struct lif_address local, peer = {};
+	unsigned int proto = 0;
+	char *key;
+
+	if (addrstr == NULL || !lif_address_parse(&local, addrstr))
+	{
+		fprintf(stderr, "static: %s: invalid mock address %s\n", cfg->ifname, addrstr != NULL ? addrstr : "");
+		return false;
+	}
+
+	while ((key = strtok_r(NULL, " \t\n", saveptr)) != NULL)
+	{
+		char *value = strtok_r(NULL, " \t\n", saveptr);
+
+		if (!strcmp(key, "peer"))
+		{
+			if (value == NULL || !lif_address_parse(&peer, value) || peer.domain != local.domain)
+			{
+				fprintf(stderr, "static: %s: invalid mock peer %s\n", cfg->ifname, value != NULL ? value : "");
+				return false;
+			}
+		}
+		else if (!strcmp(key, "proto"))
+		{
+			if (!mock_parse_number(cfg->ifname, key, value, &proto))
+				return false;
+		}
+		else
+		{
+			fprintf(stderr, "static: %s: unknown mock address option %s\n", cfg->ifname, key);
+			return false;
+		}
+	}
+
+	size_t addrlen = family_addrlen(local.domain);
+	struct ifaddrmsg ifa = {
+		.ifa_family = local.domain,
+		.ifa_prefixlen = local.netmask,
+		.ifa_scope = RT_SCOPE_UNIVERSE,
+		.ifa_index = cfg->ifindex,
+	};
+	uint8_t tag = proto;
+
+	if (!lif_netlink_batch_add(&cfg->kernel, RTM_NEWADDR, 0, &ifa, sizeof ifa) ||
+	    !lif_netlink_batch_add_attr(&cfg->kernel, IFA_LOCAL, local.addr_buf, addrlen) ||
+	    !lif_netlink_batch_add_attr(&cfg->kernel, IFA_ADDRESS, peer.domain ? peer.addr_buf : local.addr_buf, addrlen))
+		return false;
+
+	return !proto || lif_netlink_batch_add_attr(&cfg->kernel, IFA_PROTO, &tag, sizeof tag);
+}
+
+static bool
+mock_add_gateway(struct static_config *cfg, char *gwstr, char **saveptr)
+{
+	unsigned char gateway[16];
+	unsigned int table = RT_TABLE_MAIN, metric = 0, proto = 0;
+	uint32_t oif = cfg->ifindex;
+	char *key;
+
+	int family = gwstr != NULL && strchr(gwstr, ':') != NULL ? AF_INET6 : AF_INET;
+	if (gwstr == NULL || inet_pton(family, gwstr, gateway) != 1)
+	{
+		fprintf(stderr, "static: %s: invalid mock gateway %s\n", cfg->ifname, gwstr != NULL ? gwstr : "");
+		return false;
+	}
+
+	while ((key = strtok_r(NULL, " \t\n", saveptr)) != NULL)
+	{
+		char *value = strtok_r(NULL, " \t\n", saveptr);
+		unsigned int *out;
+
+		if (!strcmp(key, "table"))
+			out = &table;
+		else if (!strcmp(key, "metric"))
+			out = &metric;
+		else if (!strcmp(key, "proto"))
+			out = &proto;
+		else
+		{
+			fprintf(stderr, "static: %s: unknown mock gateway option %s\n", cfg->ifname, key);
+			return false;
+		}
+
+		if (!mock_parse_number(cfg->ifname, key, value, out))
+			return false;
+	}
+
+	struct rtmsg rtm = {
+		.rtm_family = family,
+		.rtm_table = table < 256 ? table : RT_TABLE_UNSPEC,
+		.rtm_protocol = proto,
+		.rtm_scope = RT_SCOPE_UNIVERSE,
+		.rtm_type = RTN_UNICAST,
+	};
+
+	return lif_netlink_batch_add(&cfg->kernel, RTM_NEWROUTE, 0, &rtm, sizeof rtm) &&
+	       lif_netlink_batch_add_attr(&cfg->kernel, RTA_GATEWAY, gateway, family_addrlen(family)) &&
+	       lif_netlink_batch_add_attr(&cfg->kernel, RTA_OIF, &oif, sizeof oif) &&
+	       lif_netlink_batch_add_attr(&cfg->kernel, RTA_PRIORITY, &metric, sizeof metric) &&
+	       lif_netlink_batch_add_attr(&cfg->kernel, RTA_TABLE, &table, sizeof table);
+}
+
+/*
+ * Build the messages the kernel would have answered our dumps with from
+ * the mock dump file, so that they take the same path as real ones.
+ */
+static bool
+mock_load(struct static_config *cfg, const char *path)
+{
+	char line[512];
+	bool ret = true;
+
+	if (path == NULL)
+		return true;
+
+	FILE *f = fopen(path, "r");
+	if (f == NULL)
+	{
+		fprintf(stderr, "static: %s: could not open %s: %s\n", cfg->ifname, path, strerror(errno));
+		return false;
+	}
+
+	while (ret && fgets(line, sizeof line, f) != NULL)
+	{
+		char *saveptr;
+		char *type = strtok_r(line, " \t\n", &saveptr);
+
+		if (type == NULL || *type == '#')
+			continue;
+
+		char *value = strtok_r(NULL, " \t\n", &saveptr);
+
+		if (!strcmp(type, "address"))
+			ret = mock_add_address(cfg, value, &saveptr);
+		else if (!strcmp(type, "gateway"))
+			ret = mock_add_gateway(cfg, value, &saveptr);
+		else
+		{
+			fprintf(stderr, "static: %s: unknown mock entry %s\n", cfg->ifname, type);
+			ret = false;
+		}
+	}
+
+	fclose(f);
+	return ret;
+}
+
+/*
+ * Print a queued request in the style of ip(8), so that tests can tell
+ * what would have been sent to the kernel.
+ */
+static void
+mock_print(struct nlmsghdr *nlh, void *ctx)
+{
+	struct static_config *cfg = ctx;
+	char buf[INET6_ADDRSTRLEN + 4];
+	bool add = nlh->nlmsg_type == RTM_NEWADDR || nlh->nlmsg_type == RTM_NEWROUTE;
+
+	if (nlh->nlmsg_type == RTM_NEWADDR || nlh->nlmsg_type == RTM_DELADDR)
+	{
+		struct ifaddrmsg *ifa = NLMSG_DATA(nlh);
+		int attrlen = IFA_PAYLOAD(nlh);
+		const void *local = NULL, *address = NULL;
+		int proto = -1;
+
+		for (struct rtattr *rta = IFA_RTA(ifa); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+		{
+			if (rta->rta_type == IFA_LOCAL)
+				local = RTA_DATA(rta);
+			else if (rta->rta_type == IFA_ADDRESS)
+				address = RTA_DATA(rta);
+			else if (rta->rta_type == IFA_PROTO)
+				proto = *(uint8_t *) RTA_DATA(rta);
+		}
+
+		if (local == NULL || address == NULL)
+			return;
+
+		format_address(ifa->ifa_family, local, ifa->ifa_prefixlen, buf, sizeof buf);
+		printf("ip addr %s %s", add ? "add" : "del", buf);
+
+		if (memcmp(local, address, family_addrlen(ifa->ifa_family)))
+		{
+			format_address(ifa->ifa_family, address, 0, buf, sizeof buf);
+			printf(" peer %s", buf);
+		}
+
+		printf(" dev %s", cfg->ifname);
+		if (proto >= 0)
+			printf(" proto %d", proto);
+		printf("\n");
+	}
+	else if (nlh->nlmsg_type == RTM_NEWROUTE || nlh->nlmsg_type == RTM_DELROUTE)
+	{
+		struct rtmsg *rtm = NLMSG_DATA(nlh);
+		int attrlen = RTM_PAYLOAD(nlh);
+		const void *gateway = NULL;
+		uint32_t table = rtm->rtm_table, metric = 0;
+
+		for (struct rtattr *rta = RTM_RTA(rtm); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+		{
+			if (rta->rta_type == RTA_GATEWAY)
+				gateway = RTA_DATA(rta);
+			else if (rta->rta_type == RTA_TABLE)
+				table = *(uint32_t *) RTA_DATA(rta);
+			else if (rta->rta_type == RTA_PRIORITY)
+				metric = *(uint32_t *) RTA_DATA(rta);
+		}
+
+		if (gateway == NULL)
+			return;
+
+		format_address(rtm->rtm_family, gateway, 0, buf, sizeof buf);
+		printf("ip route %s default via %s dev %s metric %u table %u", add ? "add" : "del",
+			buf, cfg->ifname, metric, table);
+		if (add)
+			printf(" proto %u", rtm->rtm_protocol);
+		printf("\n");
+	}
+}
+
+static bool
+converge(struct lif_interface *iface, bool up)
+{
+	struct lif_netlink nl;
+	struct static_config cfg = {
+		.ifname = iface->ifname,
+		.ifindex = MOCK_IFINDEX,
+		.mock = getenv("MOCK") != NULL,
+	};
+	bool ret = false;
+
+	if (cfg.mock)
+	{
+		if (!mock_load(&cfg, getenv("MOCK_DUMP")))
+		{
+			free_config(&cfg);
+			return false;
+		}
+	}
+	else if (!lif_netlink_open(&nl))
+	{
+		fprintf(stderr, "static: %s: could not open rtnetlink socket: %s\n", iface->ifname, strerror(errno));
+		return false;
+	}
+
+	if (!load_config(iface, &nl, &cfg))
+		goto out;
+
+	struct address_walk awalk = {
+		.cfg = &cfg,
+		.up = up,
+	};
+	struct ifaddrmsg ifa = {
+		.ifa_family = AF_UNSPEC,
+	};
+
+	if (!kernel_dump(&cfg, &nl, RTM_GETADDR, &ifa, sizeof ifa, address_walk, &awalk))
+	{
+		fprintf(stderr, "static: %s: could not dump addresses: %s\n", iface->ifname, strerror(errno));
+		goto out;
+	}
+
+	struct route_walk rwalk = {
+		.cfg = &cfg,
+		.up = up,
+	};
+	struct rtmsg rtm = {
+		.rtm_family = AF_UNSPEC,
+	};
+
+	if (!kernel_dump(&cfg, &nl, RTM_GETROUTE, &rtm, sizeof rtm, route_walk, &rwalk))
+	{
+		fprintf(stderr, "static: %s: could not dump routes: %s\n", iface->ifname, strerror(errno));
+		goto out;
+	}
+
+	if (cfg.failed)
+		goto out;
+
+	/* removals are queued first, so a reconfigured address can be added back right away */
+	if (up)
+	{
+		for (size_t i = 0; i < cfg.address_count; i++)
+		{
+			struct static_address *addr = &cfg.addresses[i];
+
+			if (addr->present)
+				continue;
+
+			if (!queue_address(&cfg, RTM_NEWADDR, addr->family, addr->prefixlen, addr->local,
+					   addr->has_peer ? addr->peer : addr->local, true))
+				goto out;
+		}
+
+		for (size_t i = 0; i < cfg.route_count; i++)
+		{
+			struct static_route *route = &cfg.routes[i];
+
+			if (route->present)
+				continue;
+
+			if (!queue_route(&cfg, RTM_NEWROUTE, route->family, route->gateway, cfg.table, cfg.metric))
+				goto out;
+		}
+	}
+
+	if (!cfg.batch.count && cfg.verbose)
+		fprintf(stderr, "static: %s: addresses and routes already converged\n", iface->ifname);
+
+	if (cfg.mock)
+	{
+		lif_netlink_batch_foreach(&cfg.batch, mock_print, &cfg);
+		ret = true;
+	}
+	else
+		ret = lif_netlink_batch_commit(&nl, &cfg.batch, batch_error, &cfg);
+
+out:
+	free_config(&cfg);
+	if (!cfg.mock)
+		lif_netlink_close(&nl);
+	return ret;
+}
+
+static bool
+static_up(struct lif_interface *iface)
+{
+	return converge(iface, true);
+}
+
+static bool
+static_down(struct lif_interface *iface)
+{
+	return converge(iface, false);
+}
+
+struct lif_executor lif_exec = {
+	.name = "static",
+	.up = static_up,
+	.down = static_down,
+};
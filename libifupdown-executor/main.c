@@ -27,6 +27,7 @@ struct lif_execute_opts exec_opts = {
 	.interfaces_file = INTERFACES_FILE,
 	.executor_path = EXECUTOR_PATH,
 	.state_file = STATE_FILE,
+	.snapshot_file = SNAPSHOT_FILE,
 	.timeout = DEFAULT_TIMEOUT,
 };
 
@@ -61,11 +62,16 @@ main(int argc, const char *argv[])
 
 	struct lif_dict state = {};
 	struct lif_dict collection = {};
-	struct lif_interface_file_parse_state parse_state = {
-		.collection = &collection,
-	};
 
-	lif_interface_collection_init(&collection);
+	/* ifupdown passes along the interfaces file it was told to use */
+	const char *interfaces_file = getenv("INTERFACES_FILE");
+	if (interfaces_file != NULL)
+		exec_opts.interfaces_file = interfaces_file;
+
+	/* and the snapshot it was told to use, which may be disabled */
+	const char *snapshot_file = getenv("IFUPDOWN_NG_SNAPSHOT_FILE");
+	if (snapshot_file != NULL)
+		exec_opts.snapshot_file = snapshot_file;
 
 	if (!lif_state_read_path(&state, exec_opts.state_file))
 	{
@@ -73,18 +79,12 @@ main(int argc, const char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	if (!lif_interface_file_parse(&parse_state, exec_opts.interfaces_file))
+	if (!lif_interface_file_load(&collection, exec_opts.interfaces_file, exec_opts.snapshot_file))
 	{
 		fprintf(stderr, "%s: could not parse %s\n", argv[0], exec_opts.interfaces_file);
 		return EXIT_FAILURE;
 	}
 
-	if (lif_lifecycle_count_rdepends(&exec_opts, &collection) == -1)
-	{
-		fprintf(stderr, "%s: could not validate dependency tree\n", argv[0]);
-		return EXIT_FAILURE;
-	}
-
 	if (!lif_compat_apply(&collection))
 	{
 		fprintf(stderr, "%s: failed to apply compatibility glue\n", argv[0]);
@@ -111,6 +111,12 @@ main(int argc, const char *argv[])
 		return EXIT_FAILURE;
 	}
 
+	if (!lif_lifecycle_resolve_closure(&exec_opts, &collection, &iface, 1))
+	{
+		fprintf(stderr, "%s: could not validate dependency tree\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
 	const char *phase = getenv("PHASE");
 	if (phase == NULL)
 	{
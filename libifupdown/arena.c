@@ -0,0 +1,122 @@
+/*
+ * libifupdown/arena.c
+ * Purpose: region allocator for parsed configuration
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#include <stdalign.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libifupdown/arena.h"
+
+#define LIF_ARENA_CHUNK_SIZE	65536
+
+struct lif_arena_chunk {
+	struct lif_arena_chunk *next;
+	size_t size;
+	size_t used;
+	max_align_t data[];
+};
+
+static struct lif_arena_chunk *
+arena_chunk_new(struct lif_arena *arena, size_t size)
+{
+	struct lif_arena_chunk *chunk = calloc(1, sizeof *chunk + size);
+	if (chunk == NULL)
+		return NULL;
+
+	chunk->size = size;
+	chunk->next = arena->head;
+	arena->head = chunk;
+
+	return chunk;
+}
+
+void
+lif_arena_init(struct lif_arena *arena)
+{
+	memset(arena, 0, sizeof *arena);
+}
+
+void
+lif_arena_fini(struct lif_arena *arena)
+{
+	struct lif_arena_chunk *chunk, *next;
+
+	for (chunk = arena->head; chunk != NULL; chunk = next)
+	{
+		next = chunk->next;
+		free(chunk);
+	}
+
+	arena->head = NULL;
+}
+
+static void *
+arena_alloc(struct lif_arena *arena, size_t size, size_t align)
+{
+	struct lif_arena_chunk *chunk = arena->head;
+
+	/* large allocations get a chunk of their own, so the current chunk stays usable */
+	if (size > LIF_ARENA_CHUNK_SIZE / 4)
+	{
+		struct lif_arena_chunk *head = arena->head;
+
+		chunk = arena_chunk_new(arena, size);
+		if (chunk == NULL)
+			return NULL;
+
+		if (head != NULL)
+		{
+			arena->head = head;
+			chunk->next = head->next;
+			head->next = chunk;
+		}
+
+		chunk->used = size;
+		return chunk->data;
+	}
+
+	size_t offset = chunk != NULL ? (chunk->used + align - 1) & ~(align - 1) : 0;
+
+	if (chunk == NULL || offset + size > chunk->size)
+	{
+		chunk = arena_chunk_new(arena, LIF_ARENA_CHUNK_SIZE);
+		if (chunk == NULL)
+			return NULL;
+
+		offset = 0;
+	}
+
+	chunk->used = offset + size;
+
+	return (char *) chunk->data + offset;
+}
+
+void *
+lif_arena_alloc(struct lif_arena *arena, size_t size)
+{
+	return arena_alloc(arena, size, alignof(max_align_t));
+}
+
+char *
+lif_arena_strdup(struct lif_arena *arena, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy = arena_alloc(arena, len, 1);
+
+	if (copy != NULL)
+		memcpy(copy, str, len);
+
+	return copy;
+}
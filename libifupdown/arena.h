@@ -0,0 +1,37 @@
+/*
+ * libifupdown/arena.h
+ * Purpose: region allocator for parsed configuration
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#ifndef LIBIFUPDOWN_ARENA_H__GUARD
+#define LIBIFUPDOWN_ARENA_H__GUARD
+
+#include <stddef.h>
+
+/*
+ * An arena hands out zeroed memory from large chunks.  Allocations are
+ * never freed individually, the whole arena is released at once by
+ * lif_arena_fini().
+ */
+struct lif_arena_chunk;
+
+struct lif_arena {
+	struct lif_arena_chunk *head;
+};
+
+extern void lif_arena_init(struct lif_arena *arena);
+extern void lif_arena_fini(struct lif_arena *arena);
+extern void *lif_arena_alloc(struct lif_arena *arena, size_t size);
+extern char *lif_arena_strdup(struct lif_arena *arena, const char *str);
+
+#endif
@@ -37,51 +37,49 @@ compat_ifupdown2_bridge_ports_inherit_vlans(struct lif_dict *collection)
 		if (!bridge->is_bridge)
 			continue;
 
-		struct lif_dict_entry *bridge_pvid = lif_dict_find(&bridge->vars, "bridge-pvid");
-		struct lif_dict_entry *bridge_vids = lif_dict_find(&bridge->vars, "bridge-vids");
+		struct lif_dict_entry *bridge_pvid = lif_interface_find_var(bridge, "bridge-pvid");
+		struct lif_dict_entry *bridge_vids = lif_interface_find_var(bridge, "bridge-vids");
 
 		/* If there's nothing to inherit here, carry on */
 		if (bridge_pvid == NULL && bridge_vids == NULL)
 			continue;
 
-		struct lif_dict_entry *bridge_ports_entry = lif_dict_find(&bridge->vars, "bridge-ports");
+		struct lif_dict_entry *bridge_ports_entry = lif_interface_find_var(bridge, "bridge-ports");
 
 		/* This SHOULD not happen, but better save than sorry */
 		if (bridge_ports_entry == NULL)
 			continue;
 
-		char bridge_ports_str[4096] = {};
-		strlcpy(bridge_ports_str, bridge_ports_entry->data, sizeof bridge_ports_str);
-
 		/* If there are no bridge-ports configured, carry on */
-		if (strcmp(bridge_ports_str, "none") == 0)
+		if (strcmp(bridge_ports_entry->data, "none") == 0)
 			continue;
 
+		char *bridge_ports_str = strdup(bridge_ports_entry->data);
+		if (bridge_ports_str == NULL)
+			return false;
+
 		/* Loop over all bridge-ports and set bridge-pvid and bridge-vid if not set already */
 		char *bufp = bridge_ports_str;
 		for (char *tokenp = lif_next_token(&bufp); *tokenp; tokenp = lif_next_token(&bufp))
 		{
-			entry = lif_dict_find(collection, tokenp);
+			struct lif_interface *bridge_port = lif_interface_collection_lookup(collection, tokenp);
 
 			/* There might be interfaces give within the bridge-ports for which there is no
 			 * interface stanza. If this is the case, we add one, so we can inherit the
 			 * bridge-vids/pvid to it. */
-			struct lif_interface *bridge_port;
-			if (entry)
-				bridge_port = entry->data;
-
-			else if (lif_config.compat_create_interfaces)
+			if (bridge_port == NULL && lif_config.compat_create_interfaces)
 			{
 				bridge_port = lif_interface_collection_find(collection, tokenp);
 				if (bridge_port == NULL)
 				{
 					fprintf(stderr, "Failed to add interface \"%s\"", tokenp);
+					free(bridge_ports_str);
 					return false;
 				}
 			}
 
 			/* We would have to creaet an interface, but shouldn't */
-			else
+			else if (bridge_port == NULL)
 			{
 				fprintf(stderr, "compat: Missing interface stanza for bridge-port \"%s\" but should not create one.\n",
 				        tokenp);
@@ -89,15 +87,17 @@ compat_ifupdown2_bridge_ports_inherit_vlans(struct lif_dict *collection)
 			}
 
 			/* Maybe pimp bridge-pvid */
-			struct lif_dict_entry *port_pvid = lif_dict_find(&bridge_port->vars, "bridge-pvid");
+			struct lif_dict_entry *port_pvid = lif_interface_find_var(bridge_port, "bridge-pvid");
 			if (bridge_pvid && !port_pvid)
 				lif_dict_add(&bridge_port->vars, "bridge-pvid", bridge_pvid->data);
 
 			/* Maybe pimp bridge-vids */
-			struct lif_dict_entry *port_vids = lif_dict_find(&bridge_port->vars, "bridge-vids");
+			struct lif_dict_entry *port_vids = lif_interface_find_var(bridge_port, "bridge-vids");
 			if (bridge_vids && !port_vids)
 				lif_dict_add(&bridge_port->vars, "bridge-vids", bridge_vids->data);
 		}
+
+		free(bridge_ports_str);
 	}
 
 	return true;
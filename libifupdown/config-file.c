@@ -26,6 +26,7 @@ struct lif_config_file lif_config = {
 	.compat_ifupdown2_bridge_ports_inherit_vlans = true,
 	.implicit_template_conversion = true,
 	.use_hostname_for_dhcp = true,
+	.state_format = LIF_STATE_FORMAT_TEXT,
 };
 
 static bool
@@ -47,6 +48,23 @@ set_bool_value(const char *key, const char *value, void *opaque)
 	return true;
 }
 
+static bool
+set_state_format(const char *key, const char *value, void *opaque)
+{
+	(void) key;
+
+	if (!strcmp(value, "text"))
+		*(enum lif_state_format *) opaque = LIF_STATE_FORMAT_TEXT;
+	else if (!strcmp(value, "binary"))
+		*(enum lif_state_format *) opaque = LIF_STATE_FORMAT_BINARY;
+	else if (!strcmp(value, "journal"))
+		*(enum lif_state_format *) opaque = LIF_STATE_FORMAT_JOURNAL;
+	else
+		return false;
+
+	return true;
+}
+
 static struct lif_config_handler handlers[] = {
 	{"allow_addon_scripts", set_bool_value, &lif_config.allow_addon_scripts},
 	{"allow_any_iface_as_template", set_bool_value, &lif_config.allow_any_iface_as_template},
@@ -54,6 +72,7 @@ static struct lif_config_handler handlers[] = {
 	{"compat_create_interfaces", set_bool_value, &lif_config.compat_create_interfaces},
 	{"compat_ifupdown2_bridge_ports_inherit_vlans", set_bool_value, &lif_config.compat_ifupdown2_bridge_ports_inherit_vlans},
 	{"implicit_template_conversion", set_bool_value, &lif_config.implicit_template_conversion},
+	{"state_format", set_state_format, &lif_config.state_format},
 	{"use_hostname_for_dhcp", set_bool_value, &lif_config.use_hostname_for_dhcp},
 };
 
@@ -18,6 +18,12 @@
 
 #include <stdbool.h>
 
+enum lif_state_format {
+	LIF_STATE_FORMAT_TEXT,
+	LIF_STATE_FORMAT_BINARY,
+	LIF_STATE_FORMAT_JOURNAL,
+};
+
 struct lif_config_file {
 	bool allow_addon_scripts;
 	bool allow_any_iface_as_template;
@@ -26,6 +32,7 @@ struct lif_config_file {
 	bool compat_ifupdown2_bridge_ports_inherit_vlans;
 	bool implicit_template_conversion;
 	bool use_hostname_for_dhcp;
+	enum lif_state_format state_format;
 };
 
 extern struct lif_config_file lif_config;
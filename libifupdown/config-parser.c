@@ -34,12 +34,19 @@ handler_cmp(const void *a, const void *b)
 bool
 lif_config_parse_file(FILE *fd, const char *filename, struct lif_config_handler *handlers, size_t handler_count)
 {
-	char linebuf[4096];
+	struct lif_line_reader reader;
 	size_t lineno = 0;
+	char *line;
 
-	while (lif_fgetline(linebuf, sizeof linebuf, fd))
+	if (!lif_line_reader_open_stream(&reader, fd))
 	{
-		char *bufp = linebuf;
+		fclose(fd);
+		return false;
+	}
+
+	while ((line = lif_line_reader_next(&reader)) != NULL)
+	{
+		char *bufp = line;
 		char *key = lif_next_token_eq(&bufp);
 		char *value = lif_next_token_eq(&bufp);
 
@@ -63,11 +70,13 @@ lif_config_parse_file(FILE *fd, const char *filename, struct lif_config_handler
 
 		if (!hdl->handle(key, value, hdl->opaque))
 		{
+			lif_line_reader_close(&reader);
 			fclose(fd);
 			return false;
 		}
 	}
 
+	lif_line_reader_close(&reader);
 	fclose(fd);
 	return true;
 }
@@ -1,6 +1,6 @@
 /*
  * libifupdown/dict.c
- * Purpose: wrapping linked lists to provide a naive dictionary
+ * Purpose: wrapping linked lists to provide an ordered dictionary
  *
  * Copyright (c) 2020 Ariadne Conill <ariadne@dereferenced.org>
  * Copyright (c) 2020 Maximilian Wilhelm <max@sdn.clinic>
@@ -15,9 +15,198 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include "libifupdown/dict.h"
+#include "libifupdown/symbol.h"
+
+/* dictionaries smaller than this are searched linearly */
+#define LIF_DICT_INDEX_THRESHOLD	16
+#define LIF_DICT_INDEX_MIN_SIZE		32
+
+/* keys are symbols, so the hash only needs to mix the pointer */
+static unsigned int
+dict_hash(const char *key)
+{
+	uintptr_t p = (uintptr_t) key;
+
+	return (unsigned int) ((p >> 4) ^ (p >> 20)) * 2654435761u;
+}
+
+/* returns the slot holding the first entry for key, or the empty slot where it would go */
+static size_t
+index_slot(const struct lif_dict *dict, const char *key, unsigned int hash)
+{
+	size_t mask = dict->index_size - 1;
+	size_t slot = hash & mask;
+
+	while (dict->index[slot] != NULL)
+	{
+		struct lif_dict_entry *entry = dict->index[slot];
+
+		if (entry->key == key)
+			break;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return slot;
+}
+
+static bool
+index_resize(struct lif_dict *dict, size_t size)
+{
+	struct lif_dict_entry **old_index = dict->index;
+	size_t old_size = dict->index_size;
+
+	struct lif_dict_entry **index = lif_dict_alloc(dict, size * sizeof *index);
+	if (index == NULL)
+		return false;
+
+	dict->index = index;
+	dict->index_size = size;
+
+	/* only the heads of the duplicate chains live in the index */
+	for (size_t i = 0; i < old_size; i++)
+	{
+		struct lif_dict_entry *entry = old_index[i];
+
+		if (entry != NULL)
+			dict->index[index_slot(dict, entry->key, entry->hash)] = entry;
+	}
+
+	lif_dict_free(dict, old_index);
+	return true;
+}
+
+static void
+index_drop(struct lif_dict *dict)
+{
+	lif_dict_free(dict, dict->index);
+
+	dict->index = NULL;
+	dict->index_size = 0;
+	dict->index_count = 0;
+}
+
+static void
+index_insert(struct lif_dict *dict, struct lif_dict_entry *entry)
+{
+	entry->next_dup = NULL;
+
+	/* keep the load factor at or below one half, and fall back to
+	 * linear lookups rather than leave the entry out of the index.
+	 */
+	if ((dict->index_count + 1) * 2 > dict->index_size &&
+	    !index_resize(dict, dict->index_size * 2))
+	{
+		index_drop(dict);
+		return;
+	}
+
+	size_t slot = index_slot(dict, entry->key, entry->hash);
+	struct lif_dict_entry *head = dict->index[slot];
+
+	if (head == NULL)
+	{
+		dict->index[slot] = entry;
+		dict->index_count++;
+		return;
+	}
+
+	while (head->next_dup != NULL)
+		head = head->next_dup;
+
+	head->next_dup = entry;
+}
+
+static void
+index_build(struct lif_dict *dict)
+{
+	struct lif_node *iter;
+	size_t size = LIF_DICT_INDEX_MIN_SIZE;
+
+	while (size < dict->list.length * 2)
+		size *= 2;
+
+	dict->index = lif_dict_alloc(dict, size * sizeof *dict->index);
+	if (dict->index == NULL)
+		return;
+
+	dict->index_size = size;
+	dict->index_count = 0;
+
+	LIF_DICT_FOREACH(iter, dict)
+		index_insert(dict, iter->data);
+}
+
+static void
+index_remove(struct lif_dict *dict, struct lif_dict_entry *entry)
+{
+	size_t mask = dict->index_size - 1;
+	size_t slot = index_slot(dict, entry->key, entry->hash);
+	struct lif_dict_entry *head = dict->index[slot];
+
+	if (head == NULL)
+		return;
+
+	if (head != entry)
+	{
+		for (; head->next_dup != NULL; head = head->next_dup)
+		{
+			if (head->next_dup == entry)
+			{
+				head->next_dup = entry->next_dup;
+				break;
+			}
+		}
+
+		return;
+	}
+
+	if (entry->next_dup != NULL)
+	{
+		dict->index[slot] = entry->next_dup;
+		return;
+	}
+
+	/* the key is gone: empty the slot, and shift back any entries which
+	 * probed past it, so that lookups do not need tombstones.
+	 */
+	dict->index[slot] = NULL;
+	dict->index_count--;
+
+	for (size_t next = (slot + 1) & mask; dict->index[next] != NULL; next = (next + 1) & mask)
+	{
+		size_t home = dict->index[next]->hash & mask;
+
+		/* leave the entry alone if its home slot lies cyclically in (slot, next] */
+		if (slot <= next ? (home > slot && home <= next) : (home > slot || home <= next))
+			continue;
+
+		dict->index[slot] = dict->index[next];
+		dict->index[next] = NULL;
+		slot = next;
+	}
+}
+
+struct lif_dict_entry *
+lif_dict_find_next(const struct lif_dict *dict, const struct lif_dict_entry *entry)
+{
+	if (dict->index != NULL)
+		return entry->next_dup;
+
+	for (struct lif_node *iter = entry->node.next; iter != NULL; iter = iter->next)
+	{
+		struct lif_dict_entry *next = iter->data;
+
+		if (next->key == entry->key)
+			return next;
+	}
+
+	return NULL;
+}
 
 void
 lif_dict_init(struct lif_dict *dict)
@@ -36,51 +225,69 @@ lif_dict_fini(struct lif_dict *dict)
 
 		lif_dict_delete_entry(dict, entry);
 	}
+
+	index_drop(dict);
 }
 
-struct lif_dict_entry *
-lif_dict_add(struct lif_dict *dict, const char *key, void *data)
+static struct lif_dict_entry *
+dict_insert(struct lif_dict *dict, const char *key, void *data)
 {
-	struct lif_dict_entry *entry = calloc(1, sizeof *entry);
+	struct lif_dict_entry *entry = lif_dict_alloc(dict, sizeof *entry);
+	if (entry == NULL)
+		return NULL;
+
+	entry->key = lif_symbol_intern(key);
+	if (entry->key == NULL)
+	{
+		lif_dict_free(dict, entry);
+		return NULL;
+	}
 
-	entry->key = strdup(key);
 	entry->data = data;
+	entry->hash = dict_hash(entry->key);
 
 	lif_node_insert_tail(&entry->node, entry, &dict->list);
 
+	if (dict->index != NULL)
+		index_insert(dict, entry);
+	else if (dict->list.length >= LIF_DICT_INDEX_THRESHOLD)
+		index_build(dict);
+
 	return entry;
 }
 
+struct lif_dict_entry *
+lif_dict_add(struct lif_dict *dict, const char *key, void *data)
+{
+	return dict_insert(dict, key, data);
+}
+
 struct lif_dict_entry *
 lif_dict_add_once(struct lif_dict *dict, const char *key, void *data,
                   lif_dict_cmp_t compar)
 {
-	struct lif_list *existing = lif_dict_find_all(dict, key);
-	if (existing != NULL)
-	{
-		bool found = false;
-		struct lif_node *iter;
-		LIF_LIST_FOREACH(iter, existing->head)
-		{
-			if (!compar(data, iter->data))
-			{
-				found = true;
-				break;
-			}
-		}
+	struct lif_dict_entry *entry;
 
-		lif_list_free_nodes(existing);
-
-		if (found)
+	LIF_DICT_FOREACH_KEY(entry, dict, key)
+	{
+		if (!compar(data, entry->data))
 			return NULL;
 	}
 
-	struct lif_dict_entry *entry = calloc(1, sizeof *entry);
+	return dict_insert(dict, key, data);
+}
 
-	entry->key = strdup(key);
-	entry->data = data;
+/* adds a copy of value, allocated like lif_dict_strdup() */
+struct lif_dict_entry *
+lif_dict_add_string(struct lif_dict *dict, const char *key, const char *value)
+{
+	char *copy = lif_dict_strdup(dict, value);
+	if (copy == NULL)
+		return NULL;
 
-	lif_node_insert_tail(&entry->node, entry, &dict->list);
+	struct lif_dict_entry *entry = dict_insert(dict, key, copy);
+	if (entry == NULL)
+		lif_dict_free(dict, copy);
 
 	return entry;
 }
@@ -90,11 +297,19 @@ lif_dict_find(const struct lif_dict *dict, const char *key)
 {
 	struct lif_node *iter;
 
+	/* a string which was never interned cannot be a key */
+	key = lif_symbol_find(key);
+	if (key == NULL)
+		return NULL;
+
+	if (dict->index != NULL)
+		return dict->index[index_slot(dict, key, dict_hash(key))];
+
 	LIF_DICT_FOREACH(iter, dict)
 	{
 		struct lif_dict_entry *entry = iter->data;
 
-		if (!strcmp(entry->key, key))
+		if (entry->key == key)
 			return entry;
 	}
 
@@ -104,23 +319,17 @@ lif_dict_find(const struct lif_dict *dict, const char *key)
 struct lif_list *
 lif_dict_find_all(const struct lif_dict *dict, const char *key)
 {
-	struct lif_list *entries = calloc(1, sizeof *entries);
-	struct lif_node *iter;
+	struct lif_dict_entry *entry;
 
-	LIF_LIST_FOREACH(iter, dict->list.head)
-	{
-		struct lif_dict_entry *entry = iter->data;
-		if (!strcmp(entry->key, key))
-		{
-			struct lif_node *new = calloc(1, sizeof *new);
-			lif_node_insert_tail(new, entry->data, entries);
-		}
-	}
+	if (lif_dict_find(dict, key) == NULL)
+		return NULL;
 
-	if (entries->length == 0)
+	struct lif_list *entries = calloc(1, sizeof *entries);
+
+	LIF_DICT_FOREACH_KEY(entry, dict, key)
 	{
-		free(entries);
-		return NULL;
+		struct lif_node *new = calloc(1, sizeof *new);
+		lif_node_insert_tail(new, entry->data, entries);
 	}
 
 	return entries;
@@ -140,8 +349,35 @@ lif_dict_delete(struct lif_dict *dict, const char *key)
 void
 lif_dict_delete_entry(struct lif_dict *dict, struct lif_dict_entry *entry)
 {
+	if (dict->index != NULL)
+		index_remove(dict, entry);
+
 	lif_node_delete(&entry->node, &dict->list);
+	lif_dict_free(dict, entry);
+}
+
+void *
+lif_dict_alloc(const struct lif_dict *dict, size_t size)
+{
+	if (dict->arena != NULL)
+		return lif_arena_alloc(dict->arena, size);
 
-	free(entry->key);
-	free(entry);
+	return calloc(1, size);
+}
+
+char *
+lif_dict_strdup(const struct lif_dict *dict, const char *str)
+{
+	if (dict->arena != NULL)
+		return lif_arena_strdup(dict->arena, str);
+
+	return strdup(str);
+}
+
+void
+lif_dict_free(const struct lif_dict *dict, void *ptr)
+{
+	/* arena allocations are released with the arena */
+	if (dict->arena == NULL)
+		free(ptr);
 }
@@ -1,6 +1,6 @@
 /*
  * libifupdown/dict.h
- * Purpose: wrapping linked lists to provide a naive dictionary
+ * Purpose: wrapping linked lists to provide an ordered dictionary
  *
  * Copyright (c) 2020 Ariadne Conill <ariadne@dereferenced.org>
  * Copyright (c) 2020 Maximilian Wilhelm <max@sdn.clinic>
@@ -18,15 +18,42 @@
 #define LIBIFUPDOWN_DICT_H__GUARD
 
 #include "libifupdown/list.h"
+#include "libifupdown/arena.h"
 
+/*
+ * A dictionary is an ordered list of entries, which may contain several
+ * entries with the same key.  Once a dictionary grows beyond a handful of
+ * entries, an open-addressing hash index is built alongside the list.
+ * Each slot of the index points to the first entry for a key, and the
+ * entries for the same key are chained in insertion order via next_dup.
+ *
+ * Keys are interned, so entries compare keys by pointer and do not own
+ * their key.  A zero-initialized dictionary is a valid empty dictionary.
+ *
+ * If arena is set, the entries, the index and any values allocated with
+ * lif_dict_alloc() or lif_dict_strdup() come from the arena, and are only
+ * released together with it.
+ */
 struct lif_dict {
 	struct lif_list list;
+
+	struct lif_dict_entry **index;
+	size_t index_size;	/* number of slots, a power of two, or 0 if no index */
+	size_t index_count;	/* number of distinct keys in the index */
+
+	struct lif_arena *arena;
+
+	/* range templates by shape, only used by interface collections, see libifupdown/interface.c */
+	struct lif_dict *ranges;
 };
 
 struct lif_dict_entry {
 	struct lif_node node;
-	char *key;
+	const char *key;	/* a symbol, see libifupdown/symbol.h */
 	void *data;
+
+	unsigned int hash;
+	struct lif_dict_entry *next_dup;
 };
 
 #define LIF_DICT_FOREACH(iter, dict) \
@@ -38,15 +65,25 @@ struct lif_dict_entry {
 #define LIF_DICT_FOREACH_REVERSE(iter, dict) \
 	LIF_LIST_FOREACH_REVERSE((iter), (dict)->list.tail)
 
+/* walks the entries for key in insertion order, without allocating */
+#define LIF_DICT_FOREACH_KEY(entry, dict, key) \
+	for ((entry) = lif_dict_find((dict), (key)); (entry) != NULL; (entry) = lif_dict_find_next((dict), (entry)))
+
 typedef int (*lif_dict_cmp_t)(const void *, const void *);
 
 extern void lif_dict_init(struct lif_dict *dict);
 extern void lif_dict_fini(struct lif_dict *dict);
 extern struct lif_dict_entry *lif_dict_add(struct lif_dict *dict, const char *key, void *data);
 extern struct lif_dict_entry *lif_dict_add_once(struct lif_dict *dict, const char *key, void *data, lif_dict_cmp_t compar);
+extern struct lif_dict_entry *lif_dict_add_string(struct lif_dict *dict, const char *key, const char *value);
 extern struct lif_dict_entry *lif_dict_find(const struct lif_dict *dict, const char *key);
+extern struct lif_dict_entry *lif_dict_find_next(const struct lif_dict *dict, const struct lif_dict_entry *entry);
 extern struct lif_list *lif_dict_find_all(const struct lif_dict *dict, const char *key);
 extern void lif_dict_delete(struct lif_dict *dict, const char *key);
 extern void lif_dict_delete_entry(struct lif_dict *dict, struct lif_dict_entry *entry);
 
+extern void *lif_dict_alloc(const struct lif_dict *dict, size_t size);
+extern char *lif_dict_strdup(const struct lif_dict *dict, const char *str);
+extern void lif_dict_free(const struct lif_dict *dict, void *ptr);
+
 #endif
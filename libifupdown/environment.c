@@ -18,44 +18,74 @@
 #include <string.h>
 #include "libifupdown/environment.h"
 
-bool
-lif_environment_push(char **env[], const char *name, const char *val)
+void
+lif_environment_init(struct lif_environment *env)
 {
-	char buf[4096];
+	memset(env, 0, sizeof *env);
+
+	lif_arena_init(&env->arena);
+}
 
-	snprintf(buf, sizeof buf, "%s=%s", name, val);
+void
+lif_environment_fini(struct lif_environment *env)
+{
+	lif_arena_fini(&env->arena);
+	free(env->envp);
 
-	/* create an initial envp: {"foo=bar", NULL} */
-	if (*env == NULL)
+	memset(env, 0, sizeof *env);
+}
+
+static bool
+environment_append(struct lif_environment *env, char *var)
+{
+	/* keep room for the NULL terminator */
+	if (env->count + 1 >= env->capacity)
 	{
-		*env = calloc(2, sizeof (char *));
-		(*env)[0] = strdup(buf);
-		(*env)[1] = NULL;
+		size_t capacity = env->capacity ? env->capacity * 2 : 32;
+		char **envp = realloc(env->envp, capacity * sizeof *envp);
 
-		return true;
+		if (envp == NULL)
+			return false;
+
+		env->envp = envp;
+		env->capacity = capacity;
 	}
 
-	size_t nelems;
-	for (nelems = 0; (*env)[nelems] != NULL; nelems++)
-		;
+	env->envp[env->count++] = var;
+	env->envp[env->count] = NULL;
+
+	return true;
+}
+
+bool
+lif_environment_push(struct lif_environment *env, const char *name, const char *val)
+{
+	size_t namelen = strlen(name), vallen = strlen(val);
 
-	/* NULL at end, plus next env var */
-	size_t allocelems = nelems + 2;
-	*env = realloc(*env, ((allocelems + 2) * sizeof (char *)));
+	/* values such as the requires property have no length limit */
+	char *var = lif_arena_alloc(&env->arena, namelen + vallen + 2);
+	if (var == NULL)
+		return false;
 
-	(*env)[nelems] = strdup(buf);
-	(*env)[nelems + 1] = NULL;
+	memcpy(var, name, namelen);
+	var[namelen] = '=';
+	memcpy(var + namelen + 1, val, vallen + 1);
 
-	return true;
+	return environment_append(env, var);
 }
 
-void
-lif_environment_free(char **env[])
+/* adds the PHASE and MODE slots, which are rewritten by lif_environment_set_phase() */
+bool
+lif_environment_push_phase(struct lif_environment *env, const char *phase, const char *mode)
 {
-	size_t nelems;
+	lif_environment_set_phase(env, phase, mode);
 
-	for (nelems = 0; (*env)[nelems] != NULL; nelems++)
-		free((*env)[nelems]);
+	return environment_append(env, env->phase) && environment_append(env, env->mode);
+}
 
-	free(*env);
+void
+lif_environment_set_phase(struct lif_environment *env, const char *phase, const char *mode)
+{
+	snprintf(env->phase, sizeof env->phase, "PHASE=%s", phase);
+	snprintf(env->mode, sizeof env->mode, "MODE=%s", mode);
 }
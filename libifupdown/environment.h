@@ -17,8 +17,32 @@
 #define LIBIFUPDOWN_ENVIRONMENT_H__GUARD
 
 #include <stdbool.h>
+#include <stddef.h>
+#include "libifupdown/arena.h"
 
-extern bool lif_environment_push(char **env[], const char *name, const char *val);
-extern void lif_environment_free(char **env[]);
+/*
+ * An environment block is built once for an interface and passed to every
+ * executor and command run for it.  The strings are allocated from an
+ * arena, and PHASE and MODE live in fixed slots, so that moving on to the
+ * next phase only rewrites them instead of rebuilding the block.
+ */
+#define LIF_ENVIRONMENT_SLOT_LEN	32
+
+struct lif_environment {
+	struct lif_arena arena;
+
+	char **envp;		/* NULL terminated, as passed to execve */
+	size_t count;
+	size_t capacity;
+
+	char phase[LIF_ENVIRONMENT_SLOT_LEN];
+	char mode[LIF_ENVIRONMENT_SLOT_LEN];
+};
+
+extern void lif_environment_init(struct lif_environment *env);
+extern void lif_environment_fini(struct lif_environment *env);
+extern bool lif_environment_push(struct lif_environment *env, const char *name, const char *val);
+extern bool lif_environment_push_phase(struct lif_environment *env, const char *phase, const char *mode);
+extern void lif_environment_set_phase(struct lif_environment *env, const char *phase, const char *mode);
 
 #endif
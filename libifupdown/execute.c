@@ -138,12 +138,19 @@ lif_execute_fmt(const struct lif_execute_opts *opts, char *const envp[], const c
 	return lif_process_monitor(cmdbuf, child, opts->timeout);
 }
 
+/*
+ * Runs a command and reads everything it prints into *result, which is
+ * allocated and must be freed by the caller.  *result is NULL if the
+ * command printed nothing.
+ */
 bool
-lif_execute_fmt_with_result(const struct lif_execute_opts *opts, char *buf, size_t bufsize, char *const envp[], const char *fmt, ...)
+lif_execute_fmt_with_result(const struct lif_execute_opts *opts, char **result, char *const envp[], const char *fmt, ...)
 {
 	char cmdbuf[4096];
 	va_list va;
 
+	*result = NULL;
+
 	va_start(va, fmt);
 	vsnprintf(cmdbuf, sizeof cmdbuf, fmt, va);
 	va_end(va);
@@ -174,6 +181,9 @@ lif_execute_fmt_with_result(const struct lif_execute_opts *opts, char *buf, size
 	if (posix_spawn(&child, SHELL, &file_actions, NULL, argv, envp) != 0)
 	{
 		fprintf(stderr, "execute '%s': %s\n", cmdbuf, strerror(errno));
+		posix_spawn_file_actions_destroy(&file_actions);
+		close(pipefds[0]);
+		close(pipefds[1]);
 		return false;
 	}
 
@@ -181,22 +191,59 @@ lif_execute_fmt_with_result(const struct lif_execute_opts *opts, char *buf, size
 
 	close(pipefds[1]);
 
-	struct pollfd pfd = {
-		.fd = pipefds[0],
-		.events = POLLIN
-	};
+	/* the output is read until the command closes its end of the pipe, however long it is */
+	char *buf = NULL;
+	size_t len = 0, alloc = 0;
+	bool ret = true;
+
+	for (;;)
+	{
+		if (len + 1 >= alloc)
+		{
+			size_t newalloc = alloc ? alloc * 2 : 1024;
+			char *newbuf = realloc(buf, newalloc);
+
+			if (newbuf == NULL)
+			{
+				fprintf(stderr, "reading from pipe: %s\n", strerror(errno));
+				ret = false;
+				break;
+			}
+
+			buf = newbuf;
+			alloc = newalloc;
+		}
+
+		ssize_t n = read(pipefds[0], buf + len, alloc - len - 1);
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		if (n < 0)
+		{
+			fprintf(stderr, "reading from pipe: %s\n", strerror(errno));
+			ret = false;
+			break;
+		}
+
+		if (n == 0)
+			break;
+
+		len += n;
+	}
+
+	close(pipefds[0]);
 
-	if (poll(&pfd, 1, -1) < 1)
-		goto no_result;
+	ret = lif_process_monitor(cmdbuf, child, opts->timeout) && ret;
 
-	if (read(pipefds[0], buf, bufsize) < 0)
+	if (ret && len)
 	{
-		fprintf(stderr, "reading from pipe: %s\n", strerror(errno));
-		return false;
+		buf[len] = '\0';
+		*result = buf;
 	}
+	else
+		free(buf);
 
-no_result:
-	return lif_process_monitor(cmdbuf, child, opts->timeout);
+	return ret;
 }
 
 bool
@@ -230,8 +277,10 @@ lif_maybe_run_executor(const struct lif_execute_opts *opts, char *const envp[],
 }
 
 bool
-lif_maybe_run_executor_with_result(const struct lif_execute_opts *opts, char *const envp[], const char *executor, char *buf, size_t bufsize, const char *phase, const char *lifname)
+lif_maybe_run_executor_with_result(const struct lif_execute_opts *opts, char *const envp[], const char *executor, char **result, const char *phase, const char *lifname)
 {
+	*result = NULL;
+
 	if (opts->verbose)
 		fprintf(stderr, "ifupdown: %s: attempting to run %s executor for phase %s\n", lifname, executor, phase);
 
@@ -242,5 +291,5 @@ lif_maybe_run_executor_with_result(const struct lif_execute_opts *opts, char *co
 	if (!lif_file_is_executable(pathbuf))
 		return true;
 
-	return lif_execute_fmt_with_result(opts, buf, bufsize, envp, "%s", pathbuf);
+	return lif_execute_fmt_with_result(opts, result, envp, "%s", pathbuf);
 }
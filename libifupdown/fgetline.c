@@ -1,6 +1,6 @@
 /*
  * libifupdown/fgetline.c
- * Purpose: portable fgetline(3)
+ * Purpose: line reader for configuration files
  *
  * Copyright (c) 2020 Ariadne Conill <ariadne@dereferenced.org>
  *
@@ -13,111 +13,201 @@
  * from the use of this software.
  */
 
+#include <fcntl.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "libifupdown/fgetline.h"
 
-char *
-lif_fgetline(char *line, size_t size, FILE *stream)
+/* reads the whole stream into a buffer, with room for a terminating NUL */
+bool
+lif_line_reader_open_stream(struct lif_line_reader *reader, FILE *stream)
 {
-	char *s = line;
-	char *end = line + size - 2;
-	bool quoted = false;
-	int c = '\0', c2;
+	size_t capacity = 4096;
 
-	if (s == NULL)
-		return NULL;
+	memset(reader, 0, sizeof *reader);
+
+	reader->data = malloc(capacity);
+	if (reader->data == NULL)
+		return false;
 
-	while (s < end && (c = getc(stream)) != EOF)
+	for (;;)
 	{
-		if (c == '\\' && !quoted)
+		if (reader->size + 1 == capacity)
 		{
-			quoted = true;
-			continue;
+			char *newdata = realloc(reader->data, capacity * 2);
+			if (newdata == NULL)
+				goto error;
+
+			reader->data = newdata;
+			capacity *= 2;
 		}
-		else if (c == '#')
+
+		size_t n = fread(reader->data + reader->size, 1, capacity - reader->size - 1, stream);
+		if (n == 0)
+			break;
+
+		reader->size += n;
+	}
+
+	if (ferror(stream))
+		goto error;
+
+	return true;
+
+error:
+	free(reader->data);
+	reader->data = NULL;
+	return false;
+}
+
+bool
+lif_line_reader_open(struct lif_line_reader *reader, const char *path)
+{
+	struct stat st;
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+
+	memset(reader, 0, sizeof *reader);
+
+	if (fd < 0)
+		return false;
+
+	if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+	{
+		size_t size = st.st_size;
+
+		/*
+		 * The mapping is private and writable, as lines are terminated
+		 * and continuations joined in place.  The NUL after the last
+		 * line goes into the unused tail of the last page, unless the
+		 * file fills it completely and does not end with a newline.
+		 */
+		char *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
 		{
-			if (!quoted) {
-				/* Skip the rest of the line */
-				do {
-					c = getc(stream);
-				} while (c != '\n' && c != EOF);
-				*s++ = c;
-				break;
+			if (data[size - 1] == '\n' || size % (size_t) sysconf(_SC_PAGESIZE))
+			{
+				close(fd);
+
+				reader->data = data;
+				reader->size = size;
+				reader->mapped = true;
+				return true;
 			}
-			quoted = false;
-			continue;
+
+			munmap(data, size);
 		}
-		else if (c == '\n')
-		{
-			if (quoted)
-			{
-				/* Trim spaces */
-				do {
-					c2 = getc(stream);
-				} while (c2 == '\t' || c2 == ' ');
+	}
 
-				ungetc(c2, stream);
+	FILE *stream = fdopen(fd, "r");
+	if (stream == NULL)
+	{
+		close(fd);
+		return false;
+	}
 
-				quoted = false;
-				continue;
-			}
-			else
-			{
-				*s++ = c;
-			}
+	bool ret = lif_line_reader_open_stream(reader, stream);
+	fclose(stream);
 
-			break;
+	return ret;
+}
+
+void
+lif_line_reader_close(struct lif_line_reader *reader)
+{
+	if (reader->mapped)
+		munmap(reader->data, reader->size);
+	else
+		free(reader->data);
+
+	memset(reader, 0, sizeof *reader);
+}
+
+/* moves text towards the start of the line when continuations or escapes have been removed */
+static char *
+append(char *out, const char *in, size_t len)
+{
+	if (out != in)
+		memmove(out, in, len);
+
+	return out + len;
+}
+
+char *
+lif_line_reader_next(struct lif_line_reader *reader)
+{
+	char *p = reader->data + reader->pos;
+	char *end = reader->data + reader->size;
+
+	if (reader->data == NULL || p >= end)
+		return NULL;
+
+	char *line = p, *out = p;
+	bool continued;
+
+	do {
+		/* a line ends at LF, CRLF or a lone CR */
+		char *eol = memchr(p, '\n', end - p);
+		char *next = eol != NULL ? eol + 1 : end;
+
+		if (eol == NULL)
+			eol = end;
+
+		char *cr = memchr(p, '\r', eol - p);
+		if (cr != NULL)
+		{
+			eol = cr;
+			next = cr + 1 < end && cr[1] == '\n' ? cr + 2 : cr + 1;
 		}
-		else if (c == '\r')
+
+		char *hash = memchr(p, '#', eol - p);
+		char *stop = hash != NULL ? hash : eol;
+
+		continued = false;
+
+		for (char *bs = memchr(p, '\\', stop - p); bs != NULL; bs = memchr(p, '\\', stop - p))
 		{
-			*s++ = '\n';
+			out = append(out, p, bs - p);
 
-			if ((c2 = getc(stream)) == '\n')
+			if (bs + 1 == eol)
 			{
-				if (quoted)
-				{
-					quoted = false;
-					continue;
-				}
+				/* join with the next line, without its indentation */
+				p = next;
+				while (p < end && (*p == ' ' || *p == '\t'))
+					p++;
 
+				continued = true;
 				break;
 			}
 
-			ungetc(c2, stream);
+			/* an escaped # is kept, anything else is passed through with the backslash */
+			if (bs[1] != '#')
+				*out++ = '\\';
 
-			if (quoted)
+			*out++ = bs[1];
+			p = bs + 2;
+
+			if (hash != NULL && hash < p)
 			{
-				quoted = false;
-				continue;
+				hash = memchr(p, '#', eol - p);
+				stop = hash != NULL ? hash : eol;
 			}
-
-			break;
 		}
-		else
+
+		if (!continued)
 		{
-			if (quoted) {
-				*s++ = '\\';
-				quoted = false;
-			}
-			*s++ = c;
+			out = append(out, p, stop - p);
+			p = next;
 		}
+	} while (continued && p < end);
 
-	}
-
-	if (c == EOF && (s == line || ferror(stream)))
-		return NULL;
-
-	*s = '\0';
-
-	/* Remove newline character. */
-	if (s > line && *(--s) == '\n') {
-		*s = '\0';
-
-		if (s > line && *(--s) == '\r')
-			*s = '\0';
-	}
+	*out = '\0';
+	reader->pos = p - reader->data;
 
 	return line;
 }
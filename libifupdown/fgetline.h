@@ -1,6 +1,6 @@
 /*
  * libifupdown/fgetline.h
- * Purpose: portable fgetline(3)
+ * Purpose: line reader for configuration files
  *
  * Copyright (c) 2020 Ariadne Conill <ariadne@dereferenced.org>
  *
@@ -20,6 +20,22 @@
 #ifndef LIBIFUPDOWN_FGETLINE_H__GUARD
 #define LIBIFUPDOWN_FGETLINE_H__GUARD
 
-extern char *lif_fgetline(char *line, size_t size, FILE *stream);
+/*
+ * The whole file is mapped (or read, for streams) once, and lines are
+ * handed out as NUL-terminated slices of it, with comments stripped and
+ * continued lines joined in place.  A line stays valid until the reader
+ * is closed, and there is no limit on its length.
+ */
+struct lif_line_reader {
+	char *data;
+	size_t size;
+	size_t pos;
+	bool mapped;
+};
+
+extern bool lif_line_reader_open(struct lif_line_reader *reader, const char *path);
+extern bool lif_line_reader_open_stream(struct lif_line_reader *reader, FILE *stream);
+extern char *lif_line_reader_next(struct lif_line_reader *reader);
+extern void lif_line_reader_close(struct lif_line_reader *reader);
 
 #endif
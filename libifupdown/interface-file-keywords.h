@@ -0,0 +1,32 @@
+/* generated from libifupdown/interface-file-keywords.in by tools/perfect-hash, do not edit */
+
+#include <stdint.h>
+#include "libifupdown/perfect-hash.h"
+
+static const struct parser_keyword keywords[] = {
+	{"address", handle_address},
+	{"auto", handle_auto},
+	{"defaults", handle_iface},
+	{"dhcp-hostname", handle_hostname},
+	{"gateway", handle_gateway},
+	{"hostname", handle_hostname},
+	{"iface", handle_iface},
+	{"inherit", handle_inherit},
+	{"interface", handle_iface},
+	{"source", handle_source},
+	{"source-directory", handle_source_directory},
+	{"template", handle_iface},
+	{"use", handle_use},
+};
+
+static const uint16_t keywords_hash_slots[32] = {
+	0, 1, 0, 3, 0, 0, 4, 2, 0, 0, 0, 9, 0, 0, 0, 10,
+	0, 7, 0, 0, 0, 0, 0, 11, 0, 12, 6, 5, 13, 0, 0, 8,
+};
+
+static const struct lif_perfect_hash keywords_hash = {
+	.seed = 8u,
+	.mask = 31,
+	.slots = keywords_hash_slots,
+};
+
@@ -0,0 +1,111 @@
+/* generated from libifupdown/interface-file-tokens.in by tools/perfect-hash, do not edit */
+
+#include <stdint.h>
+#include "libifupdown/perfect-hash.h"
+
+static const struct remap_token tokens[] = {
+	{"accept_ra", "ipv6-accept-ra"},	/* legacy ifupdown */
+	{"autoconf", "ipv6-autoconf"},	/* legacy ifupdown */
+	{"bond-ad-sys-priority", "bond-ad-actor-sys-prio"},	/* ifupdown2 */
+	{"bond-slaves", "bond-members"},	/* legacy ifupdown, ifupdown2 */
+	{"client", "dhcp-client-id"},	/* legacy ifupdown */
+	{"dad_transmits", "ipv6-dad-transmits"},	/* legacy ifupdown */
+	{"driver-message-level", "ethtool-msglvl"},	/* Debian ethtool integration */
+	{"endpoint", "tunnel-remote"},	/* legacy ifupdown */
+	{"ethernet-autoneg", "ethtool-ethernet-autoneg"},	/* Debian ethtool integration */
+	{"ethernet-pause-autoneg", "ethtool-pause-autoneg"},	/* Debian ethtool integration */
+	{"ethernet-pause-rx", "ethtool-pause-rx"},	/* Debian ethtool integration */
+	{"ethernet-pause-tx", "ethtool-pause-tx"},	/* Debian ethtool integration */
+	{"ethernet-port", "ethtool-ethernet-port"},	/* Debian ethtool integration */
+	{"ethernet-wol", "ethtool-ethernet-wol"},	/* Debian ethtool integration */
+	{"gro-offload", "ethtool-offload-gro"},	/* ifupdown2 */
+	{"gso-offload", "ethtool-offload-gso"},	/* ifupdown2 */
+	{"hardware-dma-ring-rx", "ethtool-dma-ring-rx"},	/* Debian ethtool integration */
+	{"hardware-dma-ring-rx-jumbo", "ethtool-dma-ring-rx-jumbo"},	/* Debian ethtool integration */
+	{"hardware-dma-ring-rx-mini", "ethtool-dma-ring-rx-mini"},	/* Debian ethtool integration */
+	{"hardware-dma-ring-tx", "ethtool-dma-ring-tx"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-adaptive-rx", "ethtool-coalesce-adaptive-rx"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-adaptive-tx", "ethtool-coalesce-adaptive-tx"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-pkt-rate-high", "ethtool-coalesce-pkt-rate-high"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-pkt-rate-low", "ethtool-coalesce-pkt-rate-low"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-frames", "ethtool-coalesce-rx-frames"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-frames-high", "ethtool-coalesce-rx-frames-high"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-frames-irq", "ethtool-coalesce-rx-frames-irq"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-frames-low", "ethtool-coalesce-rx-frames-low"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-usecs", "ethtool-coalesce-rx-usecs"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-usecs-high", "ethtool-coalesce-rx-usecs-high"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-usecs-irq", "ethtool-coalesce-rx-usecs-irq"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-rx-usecs-low", "ethtool-coalesce-rx-usecs-low"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-sample-interval", "ethtool-coalesce-sample-interval"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-stats-block-usecs", "ethtool-coalesce-stats-block-usecs"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-frames", "ethtool-coalesce-tx-frames"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-frames-high", "ethtool-coalesce-tx-frames-high"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-frames-irq", "ethtool-coalesce-tx-frames-irq"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-frames-low", "ethtool-coalesce-tx-frames-low"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-usecs", "ethtool-coalesce-tx-usecs"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-usecs-high", "ethtool-coalesce-tx-usecs-high"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-usecs-irq", "ethtool-coalesce-tx-usecs-irq"},	/* Debian ethtool integration */
+	{"hardware-irq-coalesce-tx-usecs-low", "ethtool-coalesce-tx-usecs-low"},	/* Debian ethtool integration */
+	{"hostname", "dhcp-hostname"},	/* legacy ifupdown */
+	{"key", "tunnel-key"},	/* legacy ifupdown */
+	{"leasetime", "dhcp-leasetime"},	/* legacy ifupdown */
+	{"link-autoneg", "ethtool-ethernet-autoneg"},	/* ifupdown2 */
+	{"link-duplex", "ethtool-link-duplex"},	/* Debian ethtool integration */
+	{"link-fec", "ethtool-link-fec"},	/* ifupdown2 */
+	{"link-speed", "ethtool-link-speed"},	/* Debian ethtool integration */
+	{"local", "tunnel-local"},	/* legacy ifupdown */
+	{"lro-offload", "ethtool-offload-lro"},	/* ifupdown2 */
+	{"mode", "tunnel-mode"},	/* legacy ifupdown */
+	{"offload-gro", "ethtool-offload-gro"},	/* Debian ethtool integration */
+	{"offload-gso", "ethtool-offload-gso"},	/* Debian ethtool integration */
+	{"offload-lro", "ethtool-offload-lro"},	/* Debian ethtool integration */
+	{"offload-rx", "ethtool-offload-rx"},	/* Debian ethtool integration */
+	{"offload-sg", "ethtool-offload-sg"},	/* Debian ethtool integration */
+	{"offload-tso", "ethtool-offload-tso"},	/* Debian ethtool integration */
+	{"offload-tx", "ethtool-offload-tx"},	/* Debian ethtool integration */
+	{"offload-ufo", "ethtool-offload-ufo"},	/* Debian ethtool integration */
+	{"pointopoint", "point-to-point"},	/* legacy ifupdown, ifupdown2 */
+	{"provider", "ppp-provider"},	/* legacy ifupdown, ifupdown2 */
+	{"script", "dhcp-script"},	/* legacy ifupdown */
+	{"rx-offload", "ethtool-offload-rx"},	/* ifupdown2 */
+	{"tso-offload", "ethtool-offload-tso"},	/* ifupdown2 */
+	{"ttl", "tunnel-ttl"},	/* legacy ifupdown */
+	{"tunnel-endpoint", "tunnel-remote"},	/* ifupdown2 */
+	{"tunnel-physdev", "tunnel-dev"},	/* ifupdown2 */
+	{"tx-offload", "ethtool-offload-tx"},	/* ifupdown2 */
+	{"ufo-offload", "ethtool-offload-ufo"},	/* ifupdown2 */
+	{"vendor", "dhcp-vendor"},	/* legacy ifupdown */
+	{"vrf", "vrf-member"},	/* ifupdown2 */
+	{"vrrp", "vrrp-cfg"},	/* ifupdown2 */
+	{"vxlan-local-tunnelip", "vxlan-local-ip"},	/* ifupdown2 */
+	{"vxlan-remote-group", "vxlan-peer-group"},	/* ifupdown-ng */
+	{"vxlan-remoteip", "vxlan-peer-ips"},	/* ifupdown2 */
+	{"vxlan-remote-ip", "vxlan-peer-ips"},	/* ifupdown-ng */
+	{"vxlan-svcnodeip", "vxlan-peer-group"},	/* ifupdown2 */
+};
+
+static const uint16_t tokens_hash_slots[256] = {
+	7, 0, 67, 30, 0, 0, 0, 0, 0, 0, 0, 42, 44, 62, 0, 0,
+	0, 25, 0, 0, 0, 0, 0, 37, 0, 0, 12, 0, 28, 0, 0, 29,
+	0, 0, 0, 8, 0, 76, 34, 0, 0, 27, 0, 0, 72, 59, 63, 56,
+	0, 0, 0, 0, 53, 13, 0, 11, 10, 39, 0, 57, 0, 0, 0, 41,
+	1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 19, 0, 0, 0,
+	60, 0, 0, 0, 0, 0, 61, 0, 0, 51, 0, 0, 0, 0, 0, 0,
+	0, 21, 0, 0, 54, 0, 0, 0, 0, 0, 58, 0, 0, 0, 0, 0,
+	0, 0, 50, 0, 0, 43, 38, 0, 0, 0, 0, 0, 0, 9, 22, 0,
+	0, 0, 48, 0, 0, 0, 0, 36, 0, 0, 0, 24, 0, 73, 0, 0,
+	0, 0, 16, 23, 6, 64, 14, 0, 0, 0, 0, 0, 0, 66, 26, 33,
+	18, 0, 0, 0, 0, 35, 0, 0, 0, 0, 69, 65, 0, 77, 0, 0,
+	0, 0, 71, 0, 0, 0, 2, 75, 0, 0, 45, 0, 55, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 4, 46, 0, 52, 0, 0, 17, 0, 0, 0,
+	31, 0, 68, 0, 0, 47, 0, 0, 0, 0, 32, 0, 0, 40, 70, 0,
+	0, 0, 0, 0, 0, 49, 0, 0, 0, 5, 0, 3, 0, 0, 0, 78,
+	15, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 20, 74,
+};
+
+static const struct lif_perfect_hash tokens_hash = {
+	.seed = 85772u,
+	.mask = 255,
+	.slots = tokens_hash_slots,
+};
+
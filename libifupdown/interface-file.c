@@ -15,13 +15,16 @@
  */
 
 #include <ctype.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
 #include <sys/stat.h>
-#include <wordexp.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -33,107 +36,14 @@ struct remap_token {
 	const char *alternative;
 };
 
-/* this list must be in alphabetical order for bsearch */
-static const struct remap_token tokens[] = {
-	{"accept_ra", "ipv6-accept-ra"},		/* legacy ifupdown */
-	{"autoconf", "ipv6-autoconf"},			/* legacy ifupdown */
-	{"bond-ad-sys-priority", "bond-ad-actor-sys-prio"}, /* ifupdown2 */
-	{"bond-slaves", "bond-members"},		/* legacy ifupdown, ifupdown2 */
-	{"client", "dhcp-client-id"},			/* legacy ifupdown */
-	{"dad_transmits", "ipv6-dad-transmits"},	/* legacy ifupdown */
-	{"driver-message-level", "ethtool-msglvl"},	/* Debian ethtool integration */
-	{"endpoint", "tunnel-remote"},			/* legacy ifupdown */
-	{"ethernet-autoneg", "ethtool-ethernet-autoneg"},	/* Debian ethtool integration */
-	{"ethernet-pause-autoneg", "ethtool-pause-autoneg"},	/* Debian ethtool integration */
-	{"ethernet-pause-rx", "ethtool-pause-rx"},	/* Debian ethtool integration */
-	{"ethernet-pause-tx", "ethtool-pause-tx"},	/* Debian ethtool integration */
-	{"ethernet-port", "ethtool-ethernet-port"},	/* Debian ethtool integration */
-	{"ethernet-wol", "ethtool-ethernet-wol"},	/* Debian ethtool integration */
-	{"gro-offload", "ethtool-offload-gro"},		/* ifupdown2 */
-	{"gso-offload", "ethtool-offload-gso"},		/* ifupdown2 */
-	{"hardware-dma-ring-rx", "ethtool-dma-ring-rx"},		/* Debian ethtool integration */
-	{"hardware-dma-ring-rx-jumbo", "ethtool-dma-ring-rx-jumbo"},	/* Debian ethtool integration */
-	{"hardware-dma-ring-rx-mini", "ethtool-dma-ring-rx-mini"},	/* Debian ethtool integration */
-	{"hardware-dma-ring-tx", "ethtool-dma-ring-tx"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-adaptive-rx", "ethtool-coalesce-adaptive-rx"},			/* Debian ethtool integration */
-	{"hardware-irq-coalesce-adaptive-tx", "ethtool-coalesce-adaptive-tx"},			/* Debian ethtool integration */
-	{"hardware-irq-coalesce-pkt-rate-high", "ethtool-coalesce-pkt-rate-high"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-pkt-rate-low", "ethtool-coalesce-pkt-rate-low"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-frames", "ethtool-coalesce-rx-frames"},			/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-frames-high", "ethtool-coalesce-rx-frames-high"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-frames-irq", "ethtool-coalesce-rx-frames-irq"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-frames-low", "ethtool-coalesce-rx-frames-low"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-usecs", "ethtool-coalesce-rx-usecs"},			/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-usecs-high", "ethtool-coalesce-rx-usecs-high"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-usecs-irq", "ethtool-coalesce-rx-usecs-irq"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-rx-usecs-low", "ethtool-coalesce-rx-usecs-low"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-sample-interval", "ethtool-coalesce-sample-interval"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-stats-block-usecs", "ethtool-coalesce-stats-block-usecs"},	/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-frames", "ethtool-coalesce-tx-frames"},			/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-frames-high", "ethtool-coalesce-tx-frames-high"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-frames-irq", "ethtool-coalesce-tx-frames-irq"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-frames-low", "ethtool-coalesce-tx-frames-low"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-usecs", "ethtool-coalesce-tx-usecs"},			/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-usecs-high", "ethtool-coalesce-tx-usecs-high"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-usecs-irq", "ethtool-coalesce-tx-usecs-irq"},		/* Debian ethtool integration */
-	{"hardware-irq-coalesce-tx-usecs-low", "ethtool-coalesce-tx-usecs-low"},		/* Debian ethtool integration */
-	{"hostname", "dhcp-hostname"},			/* legacy ifupdown */
-	{"key", "tunnel-key"},				/* legacy ifupdown */
-	{"leasetime", "dhcp-leasetime"},		/* legacy ifupdown */
-	{"link-autoneg", "ethtool-ethernet-autoneg"},	/* ifupdown2 */
-	{"link-duplex", "ethtool-link-duplex"},		/* Debian ethtool integration */
-	{"link-fec", "ethtool-link-fec"},		/* ifupdown2 */
-	{"link-speed", "ethtool-link-speed"},		/* Debian ethtool integration */
-	{"local", "tunnel-local"},			/* legacy ifupdown */
-	{"lro-offload", "ethtool-offload-lro"},		/* ifupdown2 */
-	{"mode", "tunnel-mode"},			/* legacy ifupdown */
-	{"offload-gro", "ethtool-offload-gro"},		/* Debian ethtool integration */
-	{"offload-gso", "ethtool-offload-gso"},		/* Debian ethtool integration */
-	{"offload-lro", "ethtool-offload-lro"},		/* Debian ethtool integration */
-	{"offload-rx", "ethtool-offload-rx"},		/* Debian ethtool integration */
-	{"offload-sg", "ethtool-offload-sg"},		/* Debian ethtool integration */
-	{"offload-tso", "ethtool-offload-tso"},		/* Debian ethtool integration */
-	{"offload-tx", "ethtool-offload-tx"},		/* Debian ethtool integration */
-	{"offload-ufo", "ethtool-offload-ufo"},		/* Debian ethtool integration */
-	{"pointopoint", "point-to-point"},		/* legacy ifupdown, ifupdown2 */
-	{"provider", "ppp-provider"},			/* legacy ifupdown, ifupdown2 */
-	{"script", "dhcp-script"},			/* legacy ifupdown */
-	{"rx-offload", "ethtool-offload-rx"},		/* ifupdown2 */
-	{"tso-offload", "ethtool-offload-tso"},		/* ifupdown2 */
-	{"ttl", "tunnel-ttl"},				/* legacy ifupdown */
-	{"tunnel-endpoint", "tunnel-remote"},		/* ifupdown2 */
-	{"tunnel-physdev", "tunnel-dev"},		/* ifupdown2 */
-	{"tx-offload", "ethtool-offload-tx"},		/* ifupdown2 */
-	{"ufo-offload", "ethtool-offload-ufo"},		/* ifupdown2 */
-	{"vendor", "dhcp-vendor"},			/* legacy ifupdown */
-	{"vrf", "vrf-member"},				/* ifupdown2 */
-	{"vrrp", "vrrp-cfg"},				/* ifupdown2 */
-	{"vxlan-local-tunnelip", "vxlan-local-ip"},	/* ifupdown2 */
-	{"vxlan-remote-group", "vxlan-peer-group"},	/* ifupdown-ng */
-	{"vxlan-remoteip", "vxlan-peer-ips"},		/* ifupdown2 */
-	{"vxlan-remote-ip", "vxlan-peer-ips"},		/* ifupdown-ng */
-	{"vxlan-svcnodeip", "vxlan-peer-group"},	/* ifupdown2 */
-};
-
-static int
-token_cmp(const void *a, const void *b)
-{
-	const char *key = a;
-	const struct remap_token *token = b;
+#include "libifupdown/interface-file-tokens.h"
 
-	return strcmp(key, token->token);
-}
-
-static char *
+static const char *
 maybe_remap_token(const char *token)
 {
-	const struct remap_token *tok = NULL;
-	static char tokbuf[4096];
-
-	tok = bsearch(token, tokens, ARRAY_SIZE(tokens), sizeof(*tokens), token_cmp);
-	strlcpy(tokbuf, tok != NULL ? tok->alternative : token, sizeof tokbuf);
+	int i = lif_perfect_hash_lookup(&tokens_hash, token);
 
-	return tokbuf;
+	return i >= 0 && !strcmp(tokens[i].token, token) ? tokens[i].alternative : token;
 }
 
 static void
@@ -147,6 +57,8 @@ report_error(struct lif_interface_file_parse_state *state, const char *errfmt, .
 	va_end(va);
 
 	fprintf(stderr, "%s:%zu: %s\n", state->cur_filename, state->cur_lineno, errbuf);
+
+	state->reported_errors = true;
 }
 
 static bool
@@ -168,6 +80,17 @@ handle_address(struct lif_interface_file_parse_state *state, char *token, char *
 	return true;
 }
 
+/* an interface name with a bracket is a range, reports an error if it is not a valid one */
+static bool
+check_range(struct lif_interface_file_parse_state *state, const char *ifname)
+{
+	if (strchr(ifname, '[') == NULL || lif_interface_range_parse(ifname, NULL))
+		return true;
+
+	report_error(state, "invalid range %s, expected <prefix>[<first>-<last>]<suffix>", ifname);
+	return false;
+}
+
 static bool
 handle_auto(struct lif_interface_file_parse_state *state, char *token, char *bufp)
 {
@@ -179,6 +102,8 @@ handle_auto(struct lif_interface_file_parse_state *state, char *token, char *buf
 		report_error(state, "auto without interface");
 		return true;
 	}
+	else if (!check_range(state, ifname))
+		return true;
 	else
 	{
 		state->cur_iface = lif_interface_collection_find(state->collection, ifname);
@@ -186,6 +111,10 @@ handle_auto(struct lif_interface_file_parse_state *state, char *token, char *buf
 			return false;
 	}
 
+	/* the members of a range are auto, not the range itself */
+	if (state->cur_iface->range != NULL)
+		state->cur_iface->range->is_auto = true;
+
 	if (!state->cur_iface->is_template)
 		state->cur_iface->is_auto = true;
 
@@ -209,10 +138,8 @@ handle_gateway(struct lif_interface_file_parse_state *state, char *token, char *
 		return true;
 	}
 
-	lif_interface_use_executor(state->cur_iface, "static");
-	lif_dict_add(&state->cur_iface->vars, token, strdup(addr));
-
-	return true;
+	return lif_interface_use_executor(state->cur_iface, "static") &&
+	       lif_dict_add_string(&state->cur_iface->vars, token, addr) != NULL;
 }
 
 static bool
@@ -221,29 +148,50 @@ handle_generic(struct lif_interface_file_parse_state *state, char *token, char *
 	if (state->cur_iface == NULL)
 		return true;
 
-	token = maybe_remap_token(token);
+	const char *key = maybe_remap_token(token);
 
 	/* This smells like a bridge */
-	if (strcmp(token, "bridge-ports") == 0)
+	if (strcmp(key, "bridge-ports") == 0)
 		state->cur_iface->is_bridge = true;
 
 	/* Skip any leading whitespaces in value for <token> */
 	while (isspace (*bufp))
 		bufp++;
 
-	lif_dict_add(&state->cur_iface->vars, token, strdup(bufp));
+	if (lif_value_type_of(key) != LIF_VALUE_STRING)
+	{
+		const char *errstr;
+		struct lif_value *value = lif_value_parse(&state->cur_iface->vars, key, bufp, &errstr);
+
+		if (value == NULL)
+		{
+			report_error(state, "iface %s: invalid %s '%s': %s", state->cur_iface->ifname, key, bufp, errstr);
+			/* Mark this interface as errornous but carry on */
+			state->cur_iface->has_config_error = true;
+			return true;
+		}
+
+		if (lif_dict_add(&state->cur_iface->vars, key, value) == NULL)
+			return false;
+	}
+	else if (lif_dict_add_string(&state->cur_iface->vars, key, bufp) == NULL)
+		return false;
 
 	if (!lif_config.auto_executor_selection)
 		return true;
 
 	/* Check if token looks like <word1>-<word*> and assume <word1> is an addon */
-	char *word_end = strchr(token, '-');
+	const char *word_end = strchr(key, '-');
 	if (word_end != NULL)
 	{
 		/* Copy word1 to not mangle *token */
-		char *addon = strndup(token, word_end - token);
-		lif_interface_use_executor(state->cur_iface, addon);
+		char *addon = strndup(key, word_end - key);
+		if (addon == NULL)
+			return false;
+
+		bool ok = lif_interface_use_executor(state->cur_iface, addon);
 		free(addon);
+		return ok;
 	}
 
 	return true;
@@ -262,9 +210,7 @@ handle_hostname(struct lif_interface_file_parse_state *state, char *token, char
 	}
 
 	lif_dict_delete(&state->cur_iface->vars, "dhcp-hostname");
-	lif_dict_add(&state->cur_iface->vars, "dhcp-hostname", strdup(hostname));
-
-	return true;
+	return lif_dict_add_string(&state->cur_iface->vars, "dhcp-hostname", hostname) != NULL;
 }
 
 static bool handle_inherit(struct lif_interface_file_parse_state *state, char *token, char *bufp);
@@ -292,6 +238,13 @@ handle_iface(struct lif_interface_file_parse_state *state, char *token, char *bu
 	if (state->cur_iface != NULL)
 		lif_interface_finalize(state->cur_iface);
 
+	if (!check_range(state, ifname))
+	{
+		/* This is broken but not fatal, skip the whole stanza */
+		state->cur_iface = NULL;
+		return true;
+	}
+
 	state->cur_iface = lif_interface_collection_find(state->collection, ifname);
 	if (state->cur_iface == NULL)
 	{
@@ -316,9 +269,15 @@ handle_iface(struct lif_interface_file_parse_state *state, char *token, char *bu
 	while (*token)
 	{
 		if (!strcmp(token, "dhcp"))
-			lif_interface_use_executor(state->cur_iface, "dhcp");
+		{
+			if (!lif_interface_use_executor(state->cur_iface, "dhcp"))
+				return false;
+		}
 		else if (!strcmp(token, "ppp"))
-			lif_interface_use_executor(state->cur_iface, "ppp");
+		{
+			if (!lif_interface_use_executor(state->cur_iface, "ppp"))
+				return false;
+		}
 		else if (!strcmp(token, "inherits"))
 		{
 			if (!handle_inherit(state, token, bufp))
@@ -334,7 +293,7 @@ handle_iface(struct lif_interface_file_parse_state *state, char *token, char *bu
 	{
 		struct lif_interface *parent = lif_interface_collection_find(state->collection, "defaults");
 
-		if (!lif_interface_collection_inherit(state->cur_iface, parent))
+		if (parent == NULL || !lif_interface_collection_inherit(state->cur_iface, parent))
 		{
 			report_error(state, "iface %s: could not inherit defaults", state->cur_iface->ifname);
 			/* Mark this interface as errornous but carry on */
@@ -397,6 +356,8 @@ handle_inherit(struct lif_interface_file_parse_state *state, char *token, char *
 	return true;
 }
 
+static bool parse_files(struct lif_interface_file_parse_state *state, char *const *filenames, size_t count);
+
 static bool
 handle_source(struct lif_interface_file_parse_state *state, char *token, char *bufp)
 {
@@ -410,29 +371,56 @@ handle_source(struct lif_interface_file_parse_state *state, char *token, char *b
 		return true;
 	}
 
-	bool ok = true;
-	wordexp_t p;
-	if (wordexp(source_filename, &p, WRDE_NOCMD)) {
+	/* a new file matching the pattern changes the configuration */
+	char source_dir[4096];
+	strlcpy(source_dir, source_filename, sizeof source_dir);
+
+	char *slash = strrchr(source_dir, '/');
+	if (slash != NULL && slash != source_dir)
+	{
+		*slash = '\0';
+		lif_dict_add(&state->watched, source_dir, NULL);
+	}
+
+	/* glob(3) matches in process and sorts the matches, unlike wordexp(3), which may run a shell */
+	glob_t gl;
+	int rv = glob(source_filename, GLOB_MARK, NULL, &gl);
+	if (rv == GLOB_NOMATCH)
+		return true;
+	else if (rv != 0)
+	{
 		report_error(state, "matching pattern failed");
-		ok = false;
-		goto out;
+		return false;
 	}
 
-	for (size_t i = 0; i < p.we_wordc; i++) {
-		char *m = p.we_wordv[i];
-		struct stat sb;
-		int rv = stat(m, &sb);
-		if (i == 0 && rv == -1)
-			goto out; // no matches
-		ok &= lif_interface_file_parse(state, m);
+	/* directories are marked with a trailing slash, and skipped */
+	char **filenames = calloc(gl.gl_pathc, sizeof *filenames);
+	size_t count = 0;
+	bool ok = filenames != NULL;
+
+	for (size_t i = 0; ok && i < gl.gl_pathc; i++)
+	{
+		size_t len = strlen(gl.gl_pathv[i]);
+
+		if (len && gl.gl_pathv[i][len - 1] != '/')
+			filenames[count++] = gl.gl_pathv[i];
 	}
 
-out:
-	wordfree(&p);
+	if (ok)
+		ok = parse_files(state, filenames, count);
+
+	free(filenames);
+	globfree(&gl);
 
 	return ok;
 }
 
+static int
+filename_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
 static bool
 handle_source_directory(struct lif_interface_file_parse_state *state, char *token, char *bufp)
 {
@@ -446,6 +434,8 @@ handle_source_directory(struct lif_interface_file_parse_state *state, char *toke
 		return true;
 	}
 
+	lif_dict_add(&state->watched, source_directory, NULL);
+
 	DIR *source_dir = opendir(source_directory);
 	if (source_dir == NULL)
 	{
@@ -454,25 +444,64 @@ handle_source_directory(struct lif_interface_file_parse_state *state, char *toke
 		return true;
 	}
 
+	char **filenames = NULL;
+	size_t count = 0, capacity = 0;
+	bool ok = true;
+
 	struct dirent *dirent_p;
 	for (dirent_p = readdir(source_dir); dirent_p != NULL; dirent_p = readdir(source_dir))
 	{
 		char pathbuf[4096];
 		struct stat st;
 
+		/* the entry type usually tells regular files apart without a stat, symlinks are followed */
+		if (dirent_p->d_type != DT_REG)
+		{
+			if (dirent_p->d_type != DT_UNKNOWN && dirent_p->d_type != DT_LNK)
+				continue;
+
+			if (fstatat(dirfd(source_dir), dirent_p->d_name, &st, 0) || !S_ISREG(st.st_mode))
+				continue;
+		}
+
 		snprintf(pathbuf, sizeof pathbuf, "%s/%s", source_directory, dirent_p->d_name);
-		if (stat(pathbuf, &st) || !S_ISREG(st.st_mode))
-			continue;
 
-		if (!lif_interface_file_parse(state, pathbuf))
+		if (count == capacity)
 		{
-			closedir(source_dir);
-			return false;
+			capacity = capacity ? capacity * 2 : 64;
+
+			char **newfilenames = realloc(filenames, capacity * sizeof *filenames);
+			if (newfilenames == NULL)
+			{
+				ok = false;
+				goto out;
+			}
+
+			filenames = newfilenames;
+		}
+
+		filenames[count] = strdup(pathbuf);
+		if (filenames[count] == NULL)
+		{
+			ok = false;
+			goto out;
 		}
+
+		count++;
 	}
 
+	/* files are applied in name order, so that stanza merging does not depend on the directory layout */
+	qsort(filenames, count, sizeof *filenames, filename_cmp);
+
+	ok = parse_files(state, filenames, count);
+
+out:
+	for (size_t i = 0; i < count; i++)
+		free(filenames[i]);
+
+	free(filenames);
 	closedir(source_dir);
-	return true;
+	return ok;
 }
 
 static bool
@@ -487,8 +516,7 @@ handle_use(struct lif_interface_file_parse_state *state, char *token, char *bufp
 		return true;
 	}
 
-	lif_interface_use_executor(state->cur_iface, executor);
-	return true;
+	return lif_interface_use_executor(state->cur_iface, executor);
 }
 
 /* map keywords to parser functions */
@@ -497,78 +525,163 @@ struct parser_keyword {
 	bool (*handle)(struct lif_interface_file_parse_state *state, char *token, char *bufp);
 };
 
-static const struct parser_keyword keywords[] = {
-	{"address", handle_address},
-	{"auto", handle_auto},
-	{"defaults", handle_iface},
-	{"dhcp-hostname", handle_hostname},
-	{"gateway", handle_gateway},
-	{"hostname", handle_hostname},
-	{"iface", handle_iface},
-	{"inherit", handle_inherit},
-	{"interface", handle_iface},
-	{"source", handle_source},
-	{"source-directory", handle_source_directory},
-	{"template", handle_iface},
-	{"use", handle_use},
+#include "libifupdown/interface-file-keywords.h"
+
+static const struct parser_keyword *
+find_keyword(const char *token)
+{
+	int i = lif_perfect_hash_lookup(&keywords_hash, token);
+
+	return i >= 0 && !strcmp(keywords[i].token, token) ? &keywords[i] : NULL;
+}
+
+/*
+ * Make the strings in the keyword and remap tables the symbols for the
+ * keys they produce, so that the common keys never need to be copied.
+ */
+static void
+register_symbols(void)
+{
+	static bool registered = false;
+
+	if (registered)
+		return;
+
+	for (size_t i = 0; i < ARRAY_SIZE(keywords); i++)
+		lif_symbol_register(keywords[i].token);
+
+	for (size_t i = 0; i < ARRAY_SIZE(tokens); i++)
+		lif_symbol_register(tokens[i].alternative);
+
+	registered = true;
+}
+
+/*
+ * A file is read and split into statements before any of it is applied.
+ * Reading does not touch the collection, so the files included by source
+ * and source-directory are read by a pool of threads, while the statements
+ * are applied by the calling thread in order, exactly as if the files had
+ * been parsed one after another.
+ */
+struct parse_statement {
+	size_t lineno;
+	char *token;
+	char *bufp;
+	const struct parser_keyword *keyword;
 };
 
-static int
-keyword_cmp(const void *a, const void *b)
+struct parse_fragment {
+	const char *filename;
+	struct lif_line_reader reader;
+	struct parse_statement *statements;
+	size_t count;
+	bool ok;
+	int error;		/* errno if reading the file failed */
+};
+
+/* files read at once by the pool, which bounds the number of open mappings */
+#define PARSE_BATCH_SIZE	256
+#define PARSE_MAX_THREADS	16
+
+static void
+fragment_read(struct parse_fragment *fragment)
 {
-	const char *key = a;
-	const struct parser_keyword *token = b;
+	size_t capacity = 0, lineno = 0;
+	char *line;
+
+	if (!lif_line_reader_open(&fragment->reader, fragment->filename))
+	{
+		fragment->error = errno;
+		return;
+	}
+
+	while ((line = lif_line_reader_next(&fragment->reader)) != NULL)
+	{
+		lineno++;
+
+		char *bufp = line;
+		char *token = lif_next_token(&bufp);
+
+		if (!*token || !isalpha(*token))
+			continue;
 
-	return strcmp(key, token->token);
+		if (fragment->count == capacity)
+		{
+			capacity = capacity ? capacity * 2 : 64;
+
+			struct parse_statement *statements = realloc(fragment->statements, capacity * sizeof *statements);
+			if (statements == NULL)
+			{
+				fragment->error = ENOMEM;
+				return;
+			}
+
+			fragment->statements = statements;
+		}
+
+		fragment->statements[fragment->count++] = (struct parse_statement) {
+			.lineno = lineno,
+			.token = token,
+			.bufp = bufp,
+			.keyword = find_keyword(token),
+		};
+	}
+
+	fragment->ok = true;
 }
 
-bool
-lif_interface_file_parse(struct lif_interface_file_parse_state *state, const char *filename)
+static void
+fragment_fini(struct parse_fragment *fragment)
+{
+	lif_line_reader_close(&fragment->reader);
+	free(fragment->statements);
+}
+
+static bool
+fragment_apply(struct lif_interface_file_parse_state *state, struct parse_fragment *fragment)
 {
-	struct lif_dict_entry *entry = lif_dict_find(&state->loaded, filename);
+	struct lif_dict_entry *entry = lif_dict_find(&state->loaded, fragment->filename);
 	if (entry != NULL)
 	{
-		report_error(state, "skipping already included file %s", filename);
+		report_error(state, "skipping already included file %s", fragment->filename);
 		return true;
 	}
 
-	FILE *f = fopen(filename, "r");
-	if (f == NULL)
+	const char *old_filename = state->cur_filename;
+
+	/* reported against the source statement, or against the file itself if it is the interfaces file */
+	if (!fragment->ok)
+	{
+		if (state->cur_filename == NULL)
+			state->cur_filename = fragment->filename;
+
+		report_error(state, "while reading %s: %s", fragment->filename, strerror(fragment->error));
+		state->cur_filename = old_filename;
 		return false;
+	}
 
-	const char *old_filename = state->cur_filename;
-	state->cur_filename = filename;
+	state->cur_filename = fragment->filename;
 
 	size_t old_lineno = state->cur_lineno;
 	state->cur_lineno = 0;
 
-	lif_dict_add(&state->loaded, filename, NULL);
+	lif_dict_add(&state->loaded, fragment->filename, NULL);
 
-	char linebuf[4096];
-	while (lif_fgetline(linebuf, sizeof linebuf, f) != NULL)
+	for (size_t i = 0; i < fragment->count; i++)
 	{
-		state->cur_lineno++;
+		const struct parse_statement *stmt = &fragment->statements[i];
 
-		char *bufp = linebuf;
-		char *token = lif_next_token(&bufp);
-
-		if (!*token || !isalpha(*token))
-			continue;
-
-		const struct parser_keyword *parserkw =
-			bsearch(token, keywords, ARRAY_SIZE(keywords), sizeof(*keywords), keyword_cmp);
+		state->cur_lineno = stmt->lineno;
 
-		if (parserkw != NULL)
+		if (stmt->keyword != NULL)
 		{
-			if (!parserkw->handle(state, token, bufp))
+			if (!stmt->keyword->handle(state, stmt->token, stmt->bufp))
 				goto parse_error;
 		}
-		else if (!handle_generic(state, token, bufp))
+		else if (!handle_generic(state, stmt->token, stmt->bufp))
 			goto parse_error;
 	}
 
-	fclose(f);
-
 	/* finalize any open interface */
 	if (state->cur_iface != NULL)
 		lif_interface_finalize(state->cur_iface);
@@ -578,8 +691,146 @@ lif_interface_file_parse(struct lif_interface_file_parse_state *state, const cha
 	return true;
 
 parse_error:
-	fclose(f);
 	state->cur_filename = old_filename;
 	state->cur_lineno = old_lineno;
 	return false;
 }
+
+struct parse_pool {
+	struct parse_fragment *fragments;
+	size_t count;
+	size_t next;
+	pthread_mutex_t lock;
+};
+
+static void *
+parse_worker(void *opaque)
+{
+	struct parse_pool *pool = opaque;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&pool->lock);
+		size_t i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (i >= pool->count)
+			break;
+
+		fragment_read(&pool->fragments[i]);
+	}
+
+	return NULL;
+}
+
+/* the calling thread reads files as well, so this works even if no thread can be started */
+static void
+read_fragments(struct parse_fragment *fragments, size_t count)
+{
+	struct parse_pool pool = {
+		.fragments = fragments,
+		.count = count,
+	};
+	pthread_t threads[PARSE_MAX_THREADS];
+	size_t thread_count = 0;
+
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t wanted = ncpus > 1 ? (size_t) ncpus - 1 : 0;
+
+	if (wanted > PARSE_MAX_THREADS)
+		wanted = PARSE_MAX_THREADS;
+
+	if (wanted > count - 1)
+		wanted = count - 1;
+
+	pthread_mutex_init(&pool.lock, NULL);
+
+	while (thread_count < wanted && !pthread_create(&threads[thread_count], NULL, parse_worker, &pool))
+		thread_count++;
+
+	parse_worker(&pool);
+
+	for (size_t i = 0; i < thread_count; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&pool.lock);
+}
+
+static bool
+parse_files(struct lif_interface_file_parse_state *state, char *const *filenames, size_t count)
+{
+	struct parse_fragment *fragments = calloc(count < PARSE_BATCH_SIZE ? count : PARSE_BATCH_SIZE, sizeof *fragments);
+	if (fragments == NULL && count != 0)
+		return false;
+
+	register_symbols();
+
+	/* like the interfaces file itself, a broken fragment does not stop the rest from being applied */
+	bool ok = true;
+	for (size_t base = 0; base < count; base += PARSE_BATCH_SIZE)
+	{
+		size_t batch = count - base < PARSE_BATCH_SIZE ? count - base : PARSE_BATCH_SIZE;
+
+		memset(fragments, 0, batch * sizeof *fragments);
+		for (size_t i = 0; i < batch; i++)
+			fragments[i].filename = filenames[base + i];
+
+		read_fragments(fragments, batch);
+
+		for (size_t i = 0; i < batch; i++)
+		{
+			ok &= fragment_apply(state, &fragments[i]);
+			fragment_fini(&fragments[i]);
+		}
+	}
+
+	free(fragments);
+	return ok;
+}
+
+bool
+lif_interface_file_parse(struct lif_interface_file_parse_state *state, const char *filename)
+{
+	struct parse_fragment fragment = {
+		.filename = filename,
+	};
+
+	register_symbols();
+
+	fragment_read(&fragment);
+	bool ok = fragment_apply(state, &fragment);
+	fragment_fini(&fragment);
+
+	return ok;
+}
+
+/*
+ * Load the interfaces file into an uninitialized collection.  If a snapshot
+ * file is given, the collection is loaded from it when it is current, and
+ * otherwise the snapshot is refreshed after parsing the interfaces file.
+ */
+bool
+lif_interface_file_load(struct lif_dict *collection, const char *filename, const char *snapshot_file)
+{
+	bool use_snapshot = snapshot_file != NULL && *snapshot_file;
+
+	if (use_snapshot && lif_snapshot_load(collection, snapshot_file, filename))
+		return true;
+
+	struct lif_interface_file_parse_state state = {
+		.collection = collection,
+	};
+
+	lif_interface_collection_init(collection);
+
+	bool ok = lif_interface_file_parse(&state, filename);
+
+	/* a snapshot would hide the diagnostics printed while parsing, so only take clean ones */
+	if (ok && use_snapshot && !state.reported_errors)
+		lif_snapshot_write(collection, &state, snapshot_file, filename);
+
+	lif_dict_fini(&state.loaded);
+	lif_dict_fini(&state.watched);
+
+	return ok;
+}
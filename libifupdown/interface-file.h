@@ -27,8 +27,11 @@ struct lif_interface_file_parse_state {
 	size_t cur_lineno;
 
 	struct lif_dict loaded;
+	struct lif_dict watched;	/* directories searched for files to source */
+	bool reported_errors;
 };
 
 extern bool lif_interface_file_parse(struct lif_interface_file_parse_state *state, const char *filename);
+extern bool lif_interface_file_load(struct lif_dict *collection, const char *filename, const char *snapshot_file);
 
 #endif
@@ -19,6 +19,9 @@
 #include <sys/utsname.h>
 #include "libifupdown/interface.h"
 #include "libifupdown/config-file.h"
+#include "libifupdown/symbol.h"
+#include "libifupdown/tokenize.h"
+#include "libifupdown/value.h"
 
 bool
 lif_address_parse(struct lif_address *address, const char *presentation)
@@ -59,40 +62,15 @@ lif_address_unparse(const struct lif_address *address, char *buf, size_t buflen,
 	return true;
 }
 
-static inline size_t
-count_set_bits(const char *netmask)
-{
-        /* netmask set to CIDR length */
-	if (strchr(netmask, '.') == NULL)
-		return strtol(netmask, NULL, 10);
-
-	size_t r = 0;
-	struct in_addr in;
-
-	if (inet_pton(AF_INET, netmask, &in) == 0)
-		return r;
-
-	/* take the IP, put it in host endian order, and
-	 * flip it so that all the set bits are set to the right.
-	 * then we can simply count down from 32 and right-shift
-	 * until the bit field is all zero.
-	 */
-	unsigned int bits = htonl(in.s_addr);
-	for (bits = ~bits, r = 32; bits; bits >>= 1, r--)
-		;
-
-	return r;
-}
-
 static inline size_t
 determine_interface_netmask(const struct lif_interface *iface, const struct lif_address *addr)
 {
 	/* if netmask is not set, default to /24 or /64, ifupdown does so too */
 	size_t netmask = addr->domain == AF_INET6 ? 64 : 24;
 
-	struct lif_dict_entry *entry = lif_dict_find(&iface->vars, "netmask");
-	if (entry != NULL)
-		netmask = count_set_bits(entry->data);
+	const struct lif_value *value = lif_value_get(lif_dict_find(&iface->vars, "netmask"), LIF_VALUE_NETMASK);
+	if (value != NULL)
+		netmask = value->netmask;
 
 	return netmask;
 }
@@ -116,34 +94,54 @@ lif_address_format_cidr(const struct lif_interface *iface, struct lif_dict_entry
 	return true;
 }
 
-void
-lif_interface_init(struct lif_interface *interface, const char *ifname)
+static bool
+interface_init(struct lif_interface *interface, const char *ifname, struct lif_arena *arena)
 {
 	memset(interface, '\0', sizeof *interface);
 
-	interface->ifname = strdup(ifname);
+	interface->vars.arena = arena;
+	interface->ifname = lif_dict_strdup(&interface->vars, ifname);
+	if (interface->ifname == NULL)
+		return false;
 
-	lif_interface_use_executor(interface, "link");
+	if (!lif_interface_use_executor(interface, "link"))
+		return false;
 
 	/* keep the 'vlan' executor as a config hint for backwards compatibility */
 	if (strchr(ifname, '.') != NULL)
-		lif_interface_use_executor(interface, "vlan");
+		return lif_interface_use_executor(interface, "vlan");
+
+	return true;
+}
+
+bool
+lif_interface_init(struct lif_interface *interface, const char *ifname)
+{
+	return interface_init(interface, ifname, NULL);
 }
 
 bool
 lif_interface_address_add(struct lif_interface *interface, const char *address)
 {
-	struct lif_address *addr = calloc(1, sizeof *addr);
+	struct lif_address addr;
 
-	if (!lif_address_parse(addr, address))
-	{
-		free(addr);
+	if (!lif_address_parse(&addr, address))
+		return false;
+
+	if (!lif_interface_use_executor(interface, "static"))
 		return false;
-	}
 
-	lif_interface_use_executor(interface, "static");
+	struct lif_address *copy = lif_dict_alloc(&interface->vars, sizeof *copy);
+	if (copy == NULL)
+		return false;
 
-	lif_dict_add(&interface->vars, "address", addr);
+	memcpy(copy, &addr, sizeof *copy);
+
+	if (lif_dict_add(&interface->vars, "address", copy) == NULL)
+	{
+		lif_dict_free(&interface->vars, copy);
+		return false;
+	}
 
 	return true;
 }
@@ -174,7 +172,7 @@ lif_interface_address_delete(struct lif_interface *interface, const char *addres
 			continue;
 
 		lif_dict_delete_entry(&interface->vars, entry);
-		free(entry_addr);
+		lif_dict_free(&interface->vars, entry_addr);
 	}
 }
 
@@ -187,20 +185,35 @@ lif_interface_fini(struct lif_interface *interface)
 	{
 		struct lif_dict_entry *entry = iter->data;
 
-		free(entry->data);
+		lif_dict_free(&interface->vars, entry->data);
 		lif_dict_delete_entry(&interface->vars, entry);
 	}
 
-	free(interface->ifname);
+	lif_dict_free(&interface->vars, interface->inherits);
+	lif_dict_free(&interface->vars, interface->requires);
+	lif_dict_free(&interface->vars, interface->ifname);
 }
 
-void
-lif_interface_use_executor(struct lif_interface *interface, const char *executor)
+/* adds a copy of value for key, unless the key already has that value */
+static bool
+interface_add_once(struct lif_interface *interface, const char *key, const char *value)
 {
-	char *exec_addon = strdup(executor);
+	struct lif_dict_entry *entry;
+
+	LIF_DICT_FOREACH_KEY(entry, &interface->vars, key)
+	{
+		if (!strcmp(entry->data, value))
+			return true;
+	}
 
-	if (lif_dict_add_once(&interface->vars, "use", exec_addon, (lif_dict_cmp_t) strcmp) == NULL)
-		free(exec_addon);
+	return lif_dict_add_string(&interface->vars, key, value) != NULL;
+}
+
+bool
+lif_interface_use_executor(struct lif_interface *interface, const char *executor)
+{
+	if (!interface_add_once(interface, "use", executor))
+		return false;
 
 	/* pass requires as compatibility env vars to appropriate executors (bridge, bond) */
 	if (!strcmp(executor, "bridge"))
@@ -209,14 +222,14 @@ lif_interface_use_executor(struct lif_interface *interface, const char *executor
 		interface->is_bond = true;
 
 	if (strcmp(executor, "dhcp") || !lif_config.use_hostname_for_dhcp)
-		return;
+		return true;
 
 	/* learn a reasonable default hostname */
 	struct utsname un;
 	if (uname(&un) < 0)
-		return;
+		return true;
 
-	lif_dict_add(&interface->vars, "dhcp-hostname", strdup(un.nodename));
+	return lif_dict_add_string(&interface->vars, "dhcp-hostname", un.nodename) != NULL;
 }
 
 void
@@ -243,21 +256,152 @@ lif_interface_finalize(struct lif_interface *interface)
 
 	if (entry != NULL)
 	{
-		free(entry->data);
+		lif_dict_free(&interface->vars, entry->data);
 
 		lif_dict_delete_entry(&interface->vars, entry);
 	}
 }
 
+#define FNV1A_OFFSET_BASIS	0xcbf29ce484222325ULL
+#define FNV1A_PRIME		0x100000001b3ULL
+
+static uint64_t
+fnv1a_update(uint64_t hash, const char *str)
+{
+	/* include the terminator, so that key/value boundaries are part of the hash */
+	do
+	{
+		hash ^= (unsigned char) *str;
+		hash *= FNV1A_PRIME;
+	} while (*str++);
+
+	return hash;
+}
+
+static uint64_t
+fnv1a_update_words(uint64_t hash, const char *str)
+{
+	/* hash a whitespace separated list word by word, ignoring spacing, as fnv1a_update() would each word */
+	for (const char *word = lif_token_skip_separators(str, false); *word; )
+	{
+		const char *end = lif_token_find_end(word, false);
+
+		for (const char *p = word; p < end; p++)
+		{
+			hash ^= (unsigned char) *p;
+			hash *= FNV1A_PRIME;
+		}
+
+		hash *= FNV1A_PRIME;
+		word = lif_token_skip_separators(end, false);
+	}
+
+	return fnv1a_update(hash, "");
+}
+
+struct fingerprint_entry {
+	const struct lif_dict_entry *entry;
+	size_t index;
+};
+
+static int
+fingerprint_entry_cmp(const void *a, const void *b)
+{
+	const struct fingerprint_entry *fa = a;
+	const struct fingerprint_entry *fb = b;
+	int ret = strcmp(fa->entry->key, fb->entry->key);
+
+	if (ret)
+		return ret;
+
+	/* keep the configured order of values for the same key, e.g. for addresses */
+	return fa->index < fb->index ? -1 : fa->index > fb->index;
+}
+
+/*
+ * Compute a fingerprint of the resolved interface configuration, which
+ * is recorded in the state file when an interface is brought up.  It is
+ * meant to be computed after inheritance, dependency learning and compat
+ * processing, and covers the executors used, as they are `use` entries.
+ *
+ * Variables are hashed sorted by key, so that reordering statements in
+ * the interfaces file does not change the fingerprint, while the order
+ * of values for the same key, which can be significant, is retained.
+ * The fingerprint is never 0, so that 0 can mean "unknown".
+ */
+uint64_t
+lif_interface_fingerprint(const struct lif_interface *interface)
+{
+	struct lif_interface_vars_iter iter;
+	const struct lif_dict_entry *entry;
+	uint64_t hash = FNV1A_OFFSET_BASIS;
+	size_t count = 0, i = 0;
+
+	LIF_INTERFACE_VARS_FOREACH(entry, &iter, interface)
+		count++;
+
+	struct fingerprint_entry *entries = calloc(count ? count : 1, sizeof *entries);
+	if (entries == NULL)
+		return 0;
+
+	LIF_INTERFACE_VARS_FOREACH(entry, &iter, interface)
+	{
+		entries[i].entry = entry;
+		entries[i].index = i;
+		i++;
+	}
+
+	qsort(entries, count, sizeof *entries, fingerprint_entry_cmp);
+
+	for (i = 0; i < count; i++)
+	{
+		entry = entries[i].entry;
+
+		hash = fnv1a_update(hash, entry->key);
+
+		if (!strcmp(entry->key, "address"))
+		{
+			char addrbuf[512];
+
+			if (!lif_address_unparse(entry->data, addrbuf, sizeof addrbuf, true))
+				continue;
+
+			hash = fnv1a_update(hash, addrbuf);
+		}
+		else if (!strcmp(entry->key, "requires"))
+			hash = fnv1a_update_words(hash, entry->data);
+		else
+			hash = fnv1a_update(hash, lif_value_text(entry));
+	}
+
+	free(entries);
+
+	return hash ? hash : 1;
+}
+
+/* initializes a collection without any interfaces, not even the loopback interface */
+void
+lif_interface_collection_init_empty(struct lif_dict *collection)
+{
+	memset(collection, '\0', sizeof *collection);
+
+	collection->arena = calloc(1, sizeof *collection->arena);
+	if (collection->arena != NULL)
+		lif_arena_init(collection->arena);
+}
+
 void
 lif_interface_collection_init(struct lif_dict *collection)
 {
 	struct lif_interface *if_lo;
 
-	memset(collection, '\0', sizeof *collection);
+	lif_interface_collection_init_empty(collection);
 
 	/* always enable loopback interface as part of a collection */
 	if_lo = lif_interface_collection_find(collection, "lo");
+	if (if_lo == NULL)
+		return;
+
 	if_lo->is_auto = true;
 	if_lo->is_explicit = true;
 	lif_interface_use_executor(if_lo, "loopback");
@@ -268,6 +412,16 @@ lif_interface_collection_fini(struct lif_dict *collection)
 {
 	struct lif_node *iter, *iter_next;
 
+	/* everything in the collection lives in its arena */
+	if (collection->arena != NULL)
+	{
+		lif_arena_fini(collection->arena);
+		free(collection->arena);
+
+		memset(collection, '\0', sizeof *collection);
+		return;
+	}
+
 	LIF_DICT_FOREACH_SAFE(iter, iter_next, collection)
 	{
 		struct lif_dict_entry *entry = iter->data;
@@ -278,24 +432,330 @@ lif_interface_collection_fini(struct lif_dict *collection)
 
 		lif_dict_delete_entry(collection, entry);
 	}
+
+	if (collection->ranges != NULL)
+	{
+		lif_dict_fini(collection->ranges);
+		free(collection->ranges);
+	}
+
+	lif_dict_fini(collection);
+}
+
+static inline bool
+is_digit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+/* more digits could overflow the index, and no interface name is that long anyway */
+#define RANGE_MAX_DIGITS	9
+
+/* returns the length of the decimal number at p, or 0 if there is none */
+static size_t
+range_number(const char *p)
+{
+	size_t len = 0;
+
+	while (is_digit(p[len]))
+		len++;
+
+	/* members are named with the index in decimal, without leading zeros */
+	if (len > RANGE_MAX_DIGITS || (len > 1 && *p == '0'))
+		return 0;
+
+	return len;
+}
+
+/*
+ * Parses a range name, <prefix>[<first>-<last>]<suffix>.  The index must
+ * not be adjacent to other digits, so that the range a member belongs to
+ * can be found from the runs of digits in the member name.
+ */
+bool
+lif_interface_range_parse(const char *ifname, struct lif_interface_range *range)
+{
+	const char *open = strchr(ifname, '[');
+	if (open == NULL || (open > ifname && is_digit(open[-1])))
+		return false;
+
+	const char *first = open + 1;
+	size_t first_len = range_number(first);
+	if (!first_len || first[first_len] != '-')
+		return false;
+
+	const char *last = first + first_len + 1;
+	size_t last_len = range_number(last);
+	if (!last_len || last[last_len] != ']')
+		return false;
+
+	const char *suffix = last + last_len + 1;
+	if (is_digit(*suffix) || strpbrk(suffix, "[]") != NULL)
+		return false;
+
+	unsigned long first_index = strtoul(first, NULL, 10);
+	unsigned long last_index = strtoul(last, NULL, 10);
+	if (first_index > last_index)
+		return false;
+
+	if (range != NULL)
+	{
+		range->name = ifname;
+		range->prefix_len = open - ifname;
+		range->suffix = suffix;
+		range->first = first_index;
+		range->last = last_index;
+	}
+
+	return true;
+}
+
+/*
+ * The range templates of a collection are indexed in collection->ranges
+ * by their shape, the name with the index replaced by "[]", so that the
+ * ranges a name may belong to are found without walking the collection.
+ * Templates with the same shape are kept in the order they were added.
+ */
+static void
+range_shape(char *buf, size_t buflen, const char *ifname, size_t prefix_len, const char *suffix)
+{
+	snprintf(buf, buflen, "%.*s[]%s", (int) prefix_len, ifname, suffix);
 }
 
+static bool
+range_index_add(struct lif_dict *collection, struct lif_interface *tmpl)
+{
+	char shape[4096];
+
+	if (collection->ranges == NULL)
+	{
+		collection->ranges = lif_dict_alloc(collection, sizeof *collection->ranges);
+		if (collection->ranges == NULL)
+			return false;
+
+		collection->ranges->arena = collection->arena;
+	}
+
+	range_shape(shape, sizeof shape, tmpl->ifname, tmpl->range->prefix_len, tmpl->range->suffix);
+	return lif_dict_add(collection->ranges, shape, tmpl) != NULL;
+}
+
+static void
+range_index_delete(struct lif_dict *collection, struct lif_interface *tmpl)
+{
+	struct lif_dict_entry *entry;
+	char shape[4096];
+
+	if (collection->ranges == NULL || tmpl->range == NULL)
+		return;
+
+	range_shape(shape, sizeof shape, tmpl->ifname, tmpl->range->prefix_len, tmpl->range->suffix);
+	LIF_DICT_FOREACH_KEY(entry, collection->ranges, shape)
+	{
+		if (entry->data == tmpl)
+		{
+			lif_dict_delete_entry(collection->ranges, entry);
+			return;
+		}
+	}
+}
+
+/* makes iface a range template if its name is a range, returns false if out of memory */
+static bool
+range_init(struct lif_dict *collection, struct lif_interface *iface)
+{
+	struct lif_interface_range range;
+
+	if (!lif_interface_range_parse(iface->ifname, &range))
+		return true;
+
+	iface->range = lif_dict_alloc(&iface->vars, sizeof *iface->range);
+	if (iface->range == NULL)
+		return false;
+
+	*iface->range = range;
+	iface->is_auto = false;
+	iface->is_template = true;
+
+	return range_index_add(collection, iface);
+}
+
+/* returns the range template for the first range which contains ifname, and the index of ifname in it */
+static struct lif_interface *
+range_find(const struct lif_dict *collection, const char *ifname, unsigned long *index)
+{
+	if (collection->ranges == NULL)
+		return NULL;
+
+	for (const char *p = ifname; *p; p++)
+	{
+		if (!is_digit(*p) || (p > ifname && is_digit(p[-1])))
+			continue;
+
+		size_t len = range_number(p);
+		if (!len)
+			continue;
+
+		char shape[4096];
+		unsigned long i = strtoul(p, NULL, 10);
+		struct lif_dict_entry *entry;
+
+		range_shape(shape, sizeof shape, ifname, p - ifname, p + len);
+		LIF_DICT_FOREACH_KEY(entry, collection->ranges, shape)
+		{
+			struct lif_interface *tmpl = entry->data;
+			const struct lif_interface_range *range = tmpl->range;
+
+			if (i < range->first || i > range->last)
+				continue;
+
+			*index = i;
+			return tmpl;
+		}
+	}
+
+	return NULL;
+}
+
+static struct lif_interface *
+interface_create(struct lif_dict *collection, const char *ifname)
+{
+	struct lif_interface *iface = lif_dict_alloc(collection, sizeof *iface);
+	if (iface == NULL)
+		return NULL;
+
+	if (!interface_init(iface, ifname, collection->arena))
+		return NULL;
+
+	iface->id = collection->list.length;
+	if (lif_dict_add(collection, ifname, iface) == NULL)
+		return NULL;
+
+	return iface;
+}
+
+/* a member is instantiated like a stanza of its own, which inherits from the range template */
+static struct lif_interface *
+range_member_create(struct lif_dict *collection, struct lif_interface *tmpl, const char *ifname, unsigned long index)
+{
+	struct lif_interface *iface = interface_create(collection, ifname);
+	if (iface == NULL)
+		return NULL;
+
+	iface->is_auto = tmpl->range->is_auto;
+	iface->is_explicit = tmpl->range->is_auto;
+	iface->no_defaults = tmpl->no_defaults;
+
+	if (!lif_interface_collection_inherit(iface, tmpl))
+		return NULL;
+
+	struct lif_dict_entry *defaults = tmpl->no_defaults ? NULL : lif_dict_find(collection, "defaults");
+	if (defaults != NULL && !lif_interface_collection_inherit(iface, defaults->data))
+		return NULL;
+
+	char indexbuf[32];
+	snprintf(indexbuf, sizeof indexbuf, "%lu", index);
+	if (lif_dict_add_string(&iface->vars, "range-index", indexbuf) == NULL)
+		return NULL;
+
+	return iface;
+}
+
+/*
+ * Returns the interface named ifname, creating it if it is a member of a
+ * range, or NULL if there is no such interface.
+ */
 struct lif_interface *
-lif_interface_collection_find(struct lif_dict *collection, const char *ifname)
+lif_interface_collection_lookup(struct lif_dict *collection, const char *ifname)
 {
 	struct lif_dict_entry *entry = lif_dict_find(collection, ifname);
 
-	if (entry == NULL)
+	if (entry != NULL)
+		return entry->data;
+
+	unsigned long index;
+	struct lif_interface *tmpl = range_find(collection, ifname, &index);
+
+	if (tmpl == NULL)
+		return NULL;
+
+	return range_member_create(collection, tmpl, ifname, index);
+}
+
+/* creates all members of all ranges, which are appended to the collection */
+bool
+lif_interface_collection_expand_ranges(struct lif_dict *collection)
+{
+	struct lif_node *iter;
+
+	LIF_DICT_FOREACH(iter, collection)
 	{
-		struct lif_interface *iface = calloc(1, sizeof *iface);
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_interface *tmpl = entry->data;
+		const struct lif_interface_range *range = tmpl->range;
 
-		lif_interface_init(iface, ifname);
-		lif_dict_add(collection, ifname, iface);
+		if (range == NULL)
+			continue;
 
-		return iface;
+		for (unsigned long i = range->first; i <= range->last; i++)
+		{
+			char ifname[4096];
+
+			snprintf(ifname, sizeof ifname, "%.*s%lu%s", (int) range->prefix_len, range->name, i, range->suffix);
+
+			/* a member of an earlier range which overlaps this one is already there */
+			if (lif_dict_find(collection, ifname) != NULL)
+				continue;
+
+			if (range_member_create(collection, tmpl, ifname, i) == NULL)
+				return false;
+		}
 	}
 
-	return entry->data;
+	return true;
+}
+
+/* returns the interface named ifname, creating a placeholder if it is not configured */
+struct lif_interface *
+lif_interface_collection_find(struct lif_dict *collection, const char *ifname)
+{
+	struct lif_interface *iface = lif_interface_collection_lookup(collection, ifname);
+
+	if (iface != NULL)
+		return iface;
+
+	iface = interface_create(collection, ifname);
+	if (iface != NULL && strchr(ifname, '[') != NULL && !range_init(collection, iface))
+		return NULL;
+
+	return iface;
+}
+
+/*
+ * Adds an interface without any configuration, not even the default
+ * executors.  The name is not copied, so it must live as long as the
+ * collection, which requires the collection to have an arena.
+ */
+struct lif_interface *
+lif_interface_collection_insert(struct lif_dict *collection, char *ifname)
+{
+	if (collection->arena == NULL)
+		return NULL;
+
+	struct lif_interface *iface = lif_dict_alloc(collection, sizeof *iface);
+	if (iface == NULL)
+		return NULL;
+
+	iface->vars.arena = collection->arena;
+	iface->ifname = ifname;
+	iface->id = collection->list.length;
+	if (lif_dict_add(collection, ifname, iface) == NULL)
+		return NULL;
+
+	if (strchr(ifname, '[') != NULL && !range_init(collection, iface))
+		return NULL;
+
+	return iface;
 }
 
 struct lif_interface *
@@ -303,17 +763,18 @@ lif_interface_collection_upsert(struct lif_dict *collection, struct lif_interfac
 {
 	struct lif_dict_entry *entry = lif_dict_find(collection, interface->ifname);
 
-	if (entry == NULL)
-	{
-		lif_dict_add(collection, interface->ifname, interface);
+	if (entry != NULL && entry->data == interface)
 		return interface;
-	}
 
-	if (entry->data == interface)
-		return interface;
+	if (entry != NULL)
+		lif_interface_collection_delete(collection, entry->data);
+
+	interface->id = collection->list.length;
+	if (lif_dict_add(collection, interface->ifname, interface) == NULL)
+		return NULL;
 
-	lif_interface_collection_delete(collection, entry->data);
-	lif_dict_add(collection, interface->ifname, interface);
+	if (interface->range != NULL && !range_index_add(collection, interface))
+		return NULL;
 
 	return interface;
 }
@@ -326,10 +787,145 @@ lif_interface_collection_delete(struct lif_dict *collection, struct lif_interfac
 	if (entry == NULL)
 		return;
 
+	range_index_delete(collection, interface);
 	lif_interface_fini(interface);
-	free(interface);
+	lif_dict_free(collection, interface);
 
 	lif_dict_delete_entry(collection, entry);
+
+	/* keep the interface IDs dense */
+	struct lif_node *iter;
+	size_t id = 0;
+
+	LIF_DICT_FOREACH(iter, collection)
+	{
+		entry = iter->data;
+		struct lif_interface *iface = entry->data;
+
+		iface->id = id++;
+	}
+}
+
+/* appends dependent to the dependencies of interface, unless it is there already */
+static bool
+requires_append(struct lif_interface *interface, struct lif_interface *dependent, bool *added)
+{
+	for (size_t i = 0; i < interface->requires_count; i++)
+	{
+		if (interface->requires[i] == dependent)
+			return true;
+	}
+
+	if (interface->requires_count == interface->requires_alloc)
+	{
+		size_t alloc = interface->requires_alloc ? interface->requires_alloc * 2 : 8;
+
+		/* the arena cannot grow allocations, so copy into a new array */
+		struct lif_interface **requires = lif_dict_alloc(&interface->vars, alloc * sizeof *requires);
+		if (requires == NULL)
+			return false;
+
+		if (interface->requires_count)
+			memcpy(requires, interface->requires, interface->requires_count * sizeof *requires);
+
+		lif_dict_free(&interface->vars, interface->requires);
+		interface->requires = requires;
+		interface->requires_alloc = alloc;
+	}
+
+	interface->requires[interface->requires_count++] = dependent;
+	*added = true;
+
+	return true;
+}
+
+/* regenerates the requires property from the dependencies, which is how executors see them */
+static bool
+requires_update(struct lif_interface *interface)
+{
+	size_t strsize = 0;
+
+	for (size_t i = 0; i < interface->requires_count; i++)
+		strsize += strlen(interface->requires[i]->ifname) + 1;
+
+	char *requires = lif_dict_alloc(&interface->vars, strsize + 1);
+	if (requires == NULL)
+		return false;
+
+	char *q = requires;
+	for (size_t i = 0; i < interface->requires_count; i++)
+	{
+		size_t namelen = strlen(interface->requires[i]->ifname);
+
+		if (i)
+			*q++ = ' ';
+
+		memcpy(q, interface->requires[i]->ifname, namelen);
+		q += namelen;
+	}
+
+	*q = '\0';
+
+	/* an inherited requires property is overridden rather than modified */
+	struct lif_dict_entry *entry = lif_dict_find(&interface->vars, "requires");
+	if (entry == NULL)
+		return lif_dict_add(&interface->vars, "requires", requires) != NULL;
+
+	lif_dict_free(&interface->vars, entry->data);
+	entry->data = requires;
+
+	return true;
+}
+
+/*
+ * Appends the interfaces named in a whitespace separated list to the
+ * dependencies of an interface, creating placeholder interfaces for names
+ * which are not configured.  Duplicates are dropped, and the requires
+ * property is rewritten from the dependencies so that it stays in
+ * canonical form for executors.
+ */
+bool
+lif_interface_add_requires(struct lif_dict *collection, struct lif_interface *interface, const char *names)
+{
+	/* names may be the requires property itself, which is replaced */
+	char *buf = strdup(names);
+	if (buf == NULL)
+		return false;
+
+	char *bufp = buf;
+	bool ok = true, added = false;
+
+	for (char *tokenp = lif_next_token(&bufp); ok && *tokenp; tokenp = lif_next_token(&bufp))
+	{
+		struct lif_interface *dependent = lif_interface_collection_find(collection, tokenp);
+
+		ok = dependent != NULL && requires_append(interface, dependent, &added);
+	}
+
+	free(buf);
+
+	return ok && (!added || requires_update(interface));
+}
+
+/*
+ * Resolve the requires property of an interface into an array of
+ * interfaces, see lif_interface_add_requires().  This is done once;
+ * dependencies learned from executors are added after it, by
+ * lif_lifecycle_query_dependents().
+ */
+bool
+lif_interface_resolve_requires(struct lif_dict *collection, struct lif_interface *interface)
+{
+	if (interface->requires_resolved)
+		return true;
+
+	interface->requires_resolved = true;
+
+	struct lif_dict_entry *entry = lif_interface_find_var(interface, "requires");
+	if (entry == NULL)
+		return true;
+
+	return lif_interface_add_requires(collection, interface, entry->data);
 }
 
 bool
@@ -339,33 +935,198 @@ lif_interface_collection_inherit(struct lif_interface *interface, struct lif_int
 	if (lif_config.implicit_template_conversion)
 		parent->is_template = true;
 
-	lif_dict_add(&interface->vars, "inherit", strdup(parent->ifname));
+	/* the arena cannot grow allocations, so copy into a new array */
+	struct lif_interface **inherits = lif_dict_alloc(&interface->vars, (interface->inherits_count + 1) * sizeof *inherits);
+	if (inherits == NULL)
+		return false;
+
+	if (interface->inherits_count)
+		memcpy(inherits, interface->inherits, interface->inherits_count * sizeof *inherits);
+
+	inherits[interface->inherits_count] = parent;
+
+	lif_dict_free(&interface->vars, interface->inherits);
+	interface->inherits = inherits;
+	interface->inherits_count++;
+
+	/* the variables are not copied, they are looked up through the parent */
+	if (lif_dict_add_string(&interface->vars, "inherit", parent->ifname) == NULL)
+		return false;
+
 	interface->is_bond = parent->is_bond;
 	interface->is_bridge = parent->is_bridge;
 
-	/* copy the variables */
-	struct lif_node *iter;
-	LIF_DICT_FOREACH(iter, &parent->vars)
+	return true;
+}
+
+/* keys which collect every value along the inheritance chain, instead of being overridden */
+static const char *accumulating_keys[] = {
+	"address",
+	"create",
+	"destroy",
+	"down",
+	"gateway",
+	"inherit",
+	"post-down",
+	"post-up",
+	"pre-down",
+	"pre-up",
+	"up",
+	"use",
+};
+
+static bool
+key_accumulates(const char *key)
+{
+	static const char *symbols[sizeof accumulating_keys / sizeof *accumulating_keys];
+
+	if (symbols[0] == NULL)
 	{
-		struct lif_dict_entry *entry = iter->data;
+		for (size_t i = 0; i < sizeof accumulating_keys / sizeof *accumulating_keys; i++)
+			symbols[i] = lif_symbol_intern(accumulating_keys[i]);
+	}
 
-		if (!strcmp(entry->key, "address"))
-		{
-			struct lif_address *addr = calloc(1, sizeof *addr);
-			struct lif_address *other_addr = entry->data;
+	for (size_t i = 0; i < sizeof symbols / sizeof *symbols; i++)
+	{
+		if (symbols[i] == key)
+			return true;
+	}
 
-			memcpy(addr, other_addr, sizeof *addr);
+	return false;
+}
 
-			lif_dict_add(&interface->vars, entry->key, addr);
-		}
-		else
-		{
-			char *value = strdup(entry->data);
+static bool
+interface_has_value(const struct lif_interface *iface, const struct lif_dict_entry *entry)
+{
+	const struct lif_dict_entry *other;
 
-			if (lif_dict_add_once(&interface->vars, entry->key, value, (lif_dict_cmp_t) strcmp) == NULL)
-				free(value);
-		}
+	LIF_DICT_FOREACH_KEY(other, &iface->vars, entry->key)
+	{
+		if (!strcmp(other->data, entry->data))
+			return true;
+	}
+
+	return false;
+}
+
+/* whether an entry set on the interface at the given seen position is part of the merged view */
+static bool
+vars_entry_visible(const struct lif_interface_vars_iter *iter, const struct lif_dict_entry *entry, size_t seen_index)
+{
+	/* the own variables of the interface are always visible */
+	if (!seen_index)
+		return true;
+
+	bool accumulates = key_accumulates(entry->key);
+
+	if (accumulates && !strcmp(entry->key, "address"))
+		return true;
+
+	for (size_t i = 0; i < seen_index; i++)
+	{
+		if (accumulates ? interface_has_value(iter->seen[i], entry) : lif_dict_find(&iter->seen[i]->vars, entry->key) != NULL)
+			return false;
 	}
 
 	return true;
 }
+
+static void
+vars_iter_push(struct lif_interface_vars_iter *iter, const struct lif_interface *iface)
+{
+	/* every interface is expanded once, which also stops inheritance loops */
+	for (size_t i = 0; i < iter->seen_count; i++)
+	{
+		if (iter->seen[i] == iface)
+			return;
+	}
+
+	if (iter->depth == LIF_INTERFACE_INHERIT_MAX || iter->seen_count == LIF_INTERFACE_INHERIT_MAX)
+		return;
+
+	struct lif_interface_vars_frame *frame = &iter->stack[iter->depth++];
+
+	frame->iface = iface;
+	frame->node = iface->vars.list.head;
+	frame->inherit_index = 0;
+	frame->seen_index = iter->seen_count;
+
+	iter->seen[iter->seen_count++] = iface;
+}
+
+void
+lif_interface_vars_iter_init(struct lif_interface_vars_iter *iter, const struct lif_interface *iface, const char *key)
+{
+	iter->key = NULL;
+	iter->depth = 0;
+	iter->seen_count = 0;
+
+	if (key != NULL)
+	{
+		/* a string which was never interned cannot be a key */
+		iter->key = lif_symbol_find(key);
+		if (iter->key == NULL)
+			return;
+	}
+
+	vars_iter_push(iter, iface);
+}
+
+struct lif_dict_entry *
+lif_interface_vars_next(struct lif_interface_vars_iter *iter)
+{
+	static const char *inherit;
+
+	if (inherit == NULL)
+		inherit = lif_symbol_intern("inherit");
+
+	while (iter->depth)
+	{
+		struct lif_interface_vars_frame *frame = &iter->stack[iter->depth - 1];
+
+		if (frame->node == NULL)
+		{
+			iter->depth--;
+			continue;
+		}
+
+		struct lif_dict_entry *entry = frame->node->data;
+		size_t seen_index = frame->seen_index;
+
+		frame->node = frame->node->next;
+
+		/* splice in the parent after its inherit entry */
+		if (entry->key == inherit && frame->inherit_index < frame->iface->inherits_count)
+			vars_iter_push(iter, frame->iface->inherits[frame->inherit_index++]);
+
+		if (iter->key != NULL && entry->key != iter->key)
+			continue;
+
+		if (vars_entry_visible(iter, entry, seen_index))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/*
+ * Returns the first entry for key in the merged view of the variables of
+ * an interface.  For keys which are overridden, an own entry always wins.
+ */
+struct lif_dict_entry *
+lif_interface_find_var(const struct lif_interface *iface, const char *key)
+{
+	struct lif_interface_vars_iter iter;
+	struct lif_dict_entry *entry = lif_dict_find(&iface->vars, key);
+
+	if (entry != NULL && !key_accumulates(entry->key))
+		return entry;
+
+	if (!iface->inherits_count)
+		return entry;
+
+	LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, key)
+		return entry;
+
+	return NULL;
+}
@@ -20,6 +20,7 @@
 #include <arpa/inet.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include "libifupdown/dict.h"
 
@@ -32,6 +33,23 @@ struct lif_address {
 	int domain;
 };
 
+/*
+ * A range stanza, such as `iface bond0.[100-1099]`, is stored once, as a
+ * template interface named after the range.  Its members are created on
+ * first lookup, by lif_interface_collection_find() or
+ * lif_interface_collection_lookup(), and inherit from the range template,
+ * with the index of the member set as `range-index`.  Walking all of the
+ * interfaces requires lif_interface_collection_expand_ranges() first.
+ */
+struct lif_interface_range {
+	const char *name;	/* the name of the range template */
+	size_t prefix_len;	/* length of the name up to the opening bracket */
+	const char *suffix;	/* the name after the closing bracket */
+	unsigned long first;
+	unsigned long last;
+	bool is_auto;		/* members are auto, set by `auto` with the range name */
+};
+
 /*
  * Interfaces are contained in a dictionary, with the interfaces mapped by
  * interface name to their `struct lif_interface`.
@@ -40,7 +58,9 @@ struct lif_address {
  * to create a placeholder `struct lif_interface` with auto set to true.
  *
  * Configuration variables are simply stored in a `struct lif_dict`, which
- * can act as a multidict.
+ * can act as a multidict.  Only the variables set on the interface itself
+ * are stored there: inherited variables are looked up through the parents
+ * listed in `inherits`, see `struct lif_interface_vars_iter`.
  */
 struct lif_interface {
 	char *ifname;
@@ -55,10 +75,26 @@ struct lif_interface {
 
 	bool has_config_error;	/* error found in interface configuration */
 
+	struct lif_interface_range *range;	/* set for range templates */
+
 	struct lif_dict vars;
 
+	/* interfaces inherited from, in the order of the inherit entries in vars */
+	struct lif_interface **inherits;
+	size_t inherits_count;
+
+	size_t id;		/* dense index of the interface within its collection */
+
+	/* interfaces named by requires, see lif_interface_resolve_requires() */
+	struct lif_interface **requires;
+	size_t requires_count;
+	size_t requires_alloc;
+	bool requires_resolved;
+
 	size_t refcount;	/* > 0 if up, else 0 */
 	size_t rdepends_count;	/* > 0 if any reverse dependency */
+
+	uint64_t fingerprint;	/* configuration fingerprint when brought up, 0 if unknown */
 };
 
 #define LIF_INTERFACE_COLLECTION_FOREACH(iter, collection) \
@@ -67,22 +103,72 @@ struct lif_interface {
 #define LIF_INTERFACE_COLLECTION_FOREACH_SAFE(iter, iter_next, collection) \
 	LIF_DICT_FOREACH_SAFE((iter), (iter_next), (collection))
 
+/*
+ * Iterates over the merged view of the variables of an interface: its own
+ * variables in order, with the merged view of each parent spliced in at
+ * its inherit entry.  An inherited variable is hidden if an interface with
+ * higher precedence (the interface itself, the interfaces on the way to the
+ * parent, or a parent inherited earlier) sets the same key, or for keys
+ * which accumulate values, such as commands and executors, the same value.
+ * Inherited addresses are never hidden.
+ */
+#define LIF_INTERFACE_INHERIT_MAX	32
+
+struct lif_interface_vars_frame {
+	const struct lif_interface *iface;
+	const struct lif_node *node;
+	size_t inherit_index;	/* number of inherit entries passed in iface */
+	size_t seen_index;	/* position of iface in seen */
+};
+
+struct lif_interface_vars_iter {
+	const char *key;	/* only yield entries for this symbol, if set */
+
+	struct lif_interface_vars_frame stack[LIF_INTERFACE_INHERIT_MAX];
+	size_t depth;
+
+	/* interfaces expanded so far, in order of precedence */
+	const struct lif_interface *seen[LIF_INTERFACE_INHERIT_MAX];
+	size_t seen_count;
+};
+
+#define LIF_INTERFACE_VARS_FOREACH(entry, iter, iface) \
+	for (lif_interface_vars_iter_init((iter), (iface), NULL), (entry) = lif_interface_vars_next((iter)); \
+	     (entry) != NULL; (entry) = lif_interface_vars_next((iter)))
+
+#define LIF_INTERFACE_VARS_FOREACH_KEY(entry, iter, iface, key) \
+	for (lif_interface_vars_iter_init((iter), (iface), (key)), (entry) = lif_interface_vars_next((iter)); \
+	     (entry) != NULL; (entry) = lif_interface_vars_next((iter)))
+
+extern void lif_interface_vars_iter_init(struct lif_interface_vars_iter *iter, const struct lif_interface *iface, const char *key);
+extern struct lif_dict_entry *lif_interface_vars_next(struct lif_interface_vars_iter *iter);
+extern struct lif_dict_entry *lif_interface_find_var(const struct lif_interface *iface, const char *key);
+
 extern bool lif_address_parse(struct lif_address *address, const char *presentation);
 extern bool lif_address_unparse(const struct lif_address *address, char *buf, size_t buflen, bool with_netmask);
 extern bool lif_address_format_cidr(const struct lif_interface *iface, struct lif_dict_entry *entry, char *buf, size_t buflen);
 
-extern void lif_interface_init(struct lif_interface *interface, const char *ifname);
+extern bool lif_interface_init(struct lif_interface *interface, const char *ifname);
 extern bool lif_interface_address_add(struct lif_interface *interface, const char *address);
 extern void lif_interface_address_delete(struct lif_interface *interface, const char *address);
 extern void lif_interface_fini(struct lif_interface *interface);
-extern void lif_interface_use_executor(struct lif_interface *interface, const char *executor);
+extern bool lif_interface_use_executor(struct lif_interface *interface, const char *executor);
 extern void lif_interface_finalize(struct lif_interface *interface);
+extern uint64_t lif_interface_fingerprint(const struct lif_interface *interface);
+
+extern bool lif_interface_range_parse(const char *ifname, struct lif_interface_range *range);
 
 extern void lif_interface_collection_init(struct lif_dict *collection);
+extern void lif_interface_collection_init_empty(struct lif_dict *collection);
 extern void lif_interface_collection_fini(struct lif_dict *collection);
 extern struct lif_interface *lif_interface_collection_find(struct lif_dict *collection, const char *ifname);
+extern struct lif_interface *lif_interface_collection_lookup(struct lif_dict *collection, const char *ifname);
+extern bool lif_interface_collection_expand_ranges(struct lif_dict *collection);
+extern struct lif_interface *lif_interface_collection_insert(struct lif_dict *collection, char *ifname);
 extern struct lif_interface *lif_interface_collection_upsert(struct lif_dict *collection, struct lif_interface *interface);
 extern bool lif_interface_collection_inherit(struct lif_interface *interface, struct lif_interface *parent);
 extern void lif_interface_collection_delete(struct lif_dict *collection, struct lif_interface *interface);
+extern bool lif_interface_add_requires(struct lif_dict *collection, struct lif_interface *interface, const char *names);
+extern bool lif_interface_resolve_requires(struct lif_dict *collection, struct lif_interface *interface);
 
 #endif
@@ -17,6 +17,7 @@
 #define LIBIFUPDOWN_LIBIFUPDOWN_H__GUARD
 
 #include "libifupdown/list.h"
+#include "libifupdown/symbol.h"
 #include "libifupdown/dict.h"
 #include "libifupdown/interface.h"
 #include "libifupdown/interface-file.h"
@@ -30,6 +31,8 @@
 #include "libifupdown/config-file.h"
 #include "libifupdown/config-parser.h"
 #include "libifupdown/compat.h"
+#include "libifupdown/value.h"
+#include "libifupdown/snapshot.h"
 
 #ifndef ARRAY_SIZE
 # define ARRAY_SIZE(x)   (sizeof(x) / sizeof(*x))
@@ -15,6 +15,7 @@
  */
 
 #include <ctype.h>
+#include <errno.h>
 #include <paths.h>
 #include <string.h>
 #include <sys/types.h>
@@ -25,8 +26,10 @@
 #include "libifupdown/execute.h"
 #include "libifupdown/interface.h"
 #include "libifupdown/lifecycle.h"
+#include "libifupdown/netlink.h"
 #include "libifupdown/state.h"
 #include "libifupdown/tokenize.h"
+#include "libifupdown/value.h"
 #include "libifupdown/config-file.h"
 
 #define BUFFER_LEN 4096
@@ -34,15 +37,11 @@
 static bool
 handle_commands_for_phase(const struct lif_execute_opts *opts, char *const envp[], const struct lif_interface *iface, const char *phase)
 {
-	const struct lif_node *iter;
+	struct lif_interface_vars_iter iter;
+	const struct lif_dict_entry *entry;
 
-	LIF_DICT_FOREACH(iter, &iface->vars)
+	LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, phase)
 	{
-		const struct lif_dict_entry *entry = iter->data;
-
-		if (strcmp(entry->key, phase))
-			continue;
-
 		const char *cmd = entry->data;
 		if (!lif_execute_fmt(opts, envp, "%s", cmd))
 			return false;
@@ -67,40 +66,59 @@ handle_single_executor_for_phase(const struct lif_dict_entry *entry, const struc
 static bool
 handle_executors_for_phase(const struct lif_execute_opts *opts, char *const envp[], const struct lif_interface *iface, bool up, const char *phase)
 {
-	bool ret = true;
-	const struct lif_node *iter;
+	struct lif_interface_vars_iter iter;
+	const struct lif_dict_entry *entry;
+	size_t count = 0, i = 0;
 
 	if (up)
 	{
-		LIF_DICT_FOREACH(iter, &iface->vars) {
-			if (!handle_single_executor_for_phase(iter->data, opts, envp, phase, iface->ifname)) {
-				ret = false;
-				break;
-			}
+		LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, "use") {
+			if (!handle_single_executor_for_phase(entry, opts, envp, phase, iface->ifname))
+				return false;
 		}
+
+		return true;
 	}
-	else
+
+	/* the merged view can only be walked forward, so collect the executors to run them in reverse */
+	LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, "use")
+		count++;
+
+	if (!count)
+		return true;
+
+	const struct lif_dict_entry **entries = calloc(count, sizeof *entries);
+	if (entries == NULL)
+		return false;
+
+	LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, "use")
+		entries[i++] = entry;
+
+	bool ret = true;
+
+	while (i--)
 	{
-		LIF_DICT_FOREACH_REVERSE(iter, &iface->vars) {
-			if (!handle_single_executor_for_phase(iter->data, opts, envp, phase, iface->ifname)) {
-				ret = false;
-				break;
-			}
+		if (!handle_single_executor_for_phase(entries[i], opts, envp, phase, iface->ifname)) {
+			ret = false;
+			break;
 		}
 	}
 
+	free(entries);
+
 	return ret;
 }
 
+/* adds the interfaces each executor prints in the phase to the dependencies of the interface */
 static bool
-query_dependents_from_executors(const struct lif_execute_opts *opts, char *const envp[], const struct lif_interface *iface, char *buf, size_t bufsize, const char *phase)
+query_dependents_from_executors(const struct lif_execute_opts *opts, char *const envp[], struct lif_dict *collection, struct lif_interface *iface, const char *phase)
 {
-	const struct lif_node *iter;
+	struct lif_interface_vars_iter iter;
+	const struct lif_dict_entry *entry;
 
-	LIF_DICT_FOREACH(iter, &iface->vars)
+	LIF_INTERFACE_VARS_FOREACH_KEY(entry, &iter, iface, "use")
 	{
-		char resbuf[1024] = {};
-		const struct lif_dict_entry *entry = iter->data;
+		char *result;
 		struct lif_execute_opts exec_opts = {
 			.verbose = opts->verbose,
 			.executor_path = opts->executor_path,
@@ -108,18 +126,18 @@ query_dependents_from_executors(const struct lif_execute_opts *opts, char *const
 			.timeout = opts->timeout,
 		};
 
-		if (strcmp(entry->key, "use"))
-			continue;
-
 		const char *cmd = entry->data;
-		if (!lif_maybe_run_executor_with_result(&exec_opts, envp, cmd, resbuf, sizeof resbuf, phase, iface->ifname))
+		if (!lif_maybe_run_executor_with_result(&exec_opts, envp, cmd, &result, phase, iface->ifname))
 			return false;
 
-		if (!*resbuf)
+		if (result == NULL)
 			continue;
 
-		strlcat(buf, " ", bufsize);
-		strlcat(buf, resbuf, bufsize);
+		bool ok = lif_interface_add_requires(collection, iface, result);
+		free(result);
+
+		if (!ok)
+			return false;
 	}
 
 	return true;
@@ -159,25 +177,30 @@ append_to_buffer(char **buffer, size_t *buffer_len, char **end, const char *valu
 }
 
 static void
-build_environment(char **envp[], const struct lif_execute_opts *opts, const struct lif_interface *iface, const char *lifname, const char *phase, const char *mode)
+build_environment(struct lif_environment *env, const struct lif_execute_opts *opts, const struct lif_interface *iface, const char *lifname, const char *phase, const char *mode)
 {
 	if (lifname == NULL)
 		lifname = iface->ifname;
 
+	lif_environment_init(env);
+
 	/* Use sane defaults for PATH */
-	lif_environment_push(envp, "PATH", _PATH_STDPATH);
-	lif_environment_push(envp, "IFACE", lifname);
-	lif_environment_push(envp, "PHASE", phase);
-	lif_environment_push(envp, "MODE", mode);
-	lif_environment_push(envp, "METHOD", "none");
+	lif_environment_push(env, "PATH", _PATH_STDPATH);
+	lif_environment_push(env, "IFACE", lifname);
+	lif_environment_push_phase(env, phase, mode);
+	lif_environment_push(env, "METHOD", "none");
 
 	if (opts->verbose)
-		lif_environment_push(envp, "VERBOSE", "1");
+		lif_environment_push(env, "VERBOSE", "1");
 
 	if (opts->interfaces_file)
-		lif_environment_push(envp, "INTERFACES_FILE", opts->interfaces_file);
+		lif_environment_push(env, "INTERFACES_FILE", opts->interfaces_file);
 
-	const struct lif_node *iter;
+	if (opts->snapshot_file)
+		lif_environment_push(env, "IFUPDOWN_NG_SNAPSHOT_FILE", opts->snapshot_file);
+
+	struct lif_interface_vars_iter iter;
+	struct lif_dict_entry *entry;
 	bool did_address = false, did_gateway = false;
 
 	/* Allocate a buffer for all possible addresses, if any */
@@ -190,10 +213,8 @@ build_environment(char **envp[], const struct lif_execute_opts *opts, const stru
 	size_t gateways_size = BUFFER_LEN;
 	char *gateways_end = gateways;
 
-	LIF_DICT_FOREACH(iter, &iface->vars)
+	LIF_INTERFACE_VARS_FOREACH(entry, &iter, iface)
 	{
-		struct lif_dict_entry *entry = iter->data;
-
 		if (!strcmp(entry->key, "address"))
 		{
 			char addrbuf[4096];
@@ -208,7 +229,7 @@ build_environment(char **envp[], const struct lif_execute_opts *opts, const stru
 			if (did_address)
 				continue;
 
-			lif_environment_push(envp, "IF_ADDRESS", addrbuf);
+			lif_environment_push(env, "IF_ADDRESS", addrbuf);
 			did_address = true;
 
 			continue;
@@ -226,7 +247,7 @@ build_environment(char **envp[], const struct lif_execute_opts *opts, const stru
 		else if (!strcmp(entry->key, "requires"))
 		{
 			if (iface->is_bridge)
-				lif_environment_push(envp, "IF_BRIDGE_PORTS", (const char *) entry->data);
+				lif_environment_push(env, "IF_BRIDGE_PORTS", (const char *) entry->data);
 		}
 
 		char envkey[4096] = "IF_";
@@ -241,80 +262,61 @@ build_environment(char **envp[], const struct lif_execute_opts *opts, const stru
 				*ep = '_';
 		}
 
-		lif_environment_push(envp, envkey, (const char *) entry->data);
+		lif_environment_push(env, envkey, lif_value_text(entry));
 	}
 
 	if (addresses != NULL)
-		lif_environment_push(envp, "IF_ADDRESSES", addresses);
+		lif_environment_push(env, "IF_ADDRESSES", addresses);
 	if (gateways != NULL)
-		lif_environment_push(envp, "IF_GATEWAYS", gateways);
+		lif_environment_push(env, "IF_GATEWAYS", gateways);
 
 	/* Clean up */
 	free (addresses);
 	free (gateways);
 }
 
+/*
+ * Learns the dependencies of an interface, which are the interfaces named
+ * by its requires property followed by those its executors print in the
+ * depend phase, into its dependency array.
+ */
 bool
-lif_lifecycle_query_dependents(const struct lif_execute_opts *opts, struct lif_interface *iface, const char *lifname)
+lif_lifecycle_query_dependents(const struct lif_execute_opts *opts, struct lif_dict *collection, struct lif_interface *iface, const char *lifname)
 {
-	char deps[4096] = {};
-	char final_deps[4096] = {};
+	/* the dependency graph has already been built from what we learned */
+	if (iface->requires_resolved)
+		return true;
 
 	if (lifname == NULL)
 		lifname = iface->ifname;
 
-	char **envp = NULL;
+	struct lif_environment env;
 
-	build_environment(&envp, opts, iface, lifname, "depend", "depend");
+	build_environment(&env, opts, iface, lifname, "depend", "depend");
 
-	struct lif_dict_entry *entry = lif_dict_find(&iface->vars, "requires");
-	if (entry != NULL)
-		strlcpy(deps, entry->data, sizeof deps);
+	bool ret = lif_interface_resolve_requires(collection, iface) &&
+		query_dependents_from_executors(opts, env.envp, collection, iface, "depend");
 
-	if (!query_dependents_from_executors(opts, envp, iface, deps, sizeof deps, "depend"))
-		return false;
-
-	char *p = deps;
-	while (*p)
-	{
-		char *token = lif_next_token(&p);
-
-		if (strstr(final_deps, token) != NULL)
-			continue;
+	lif_environment_fini(&env);
 
-		strlcat(final_deps, token, sizeof final_deps);
-		strlcat(final_deps, " ", sizeof final_deps);
-	}
-
-	if (entry != NULL)
-	{
-		free(entry->data);
-		entry->data = strdup(final_deps);
-	}
-	else if (*final_deps)
-		lif_dict_add(&iface->vars, "requires", strdup(final_deps));
-
-	lif_environment_free(&envp);
-
-	return true;
+	return ret;
 }
 
-bool
-lif_lifecycle_run_phase(const struct lif_execute_opts *opts, struct lif_interface *iface, const char *phase, const char *lifname, bool up)
+/* runs a phase with an environment built for the interface, switching it to the phase */
+static bool
+run_phase(const struct lif_execute_opts *opts, struct lif_environment *env, const struct lif_interface *iface, const char *phase, bool up)
 {
-	char **envp = NULL;
-
-	build_environment(&envp, opts, iface, lifname, phase, up ? "start" : "stop");
+	lif_environment_set_phase(env, phase, up ? "start" : "stop");
 
-	if (!handle_executors_for_phase(opts, envp, iface, up, phase))
-		goto handle_error;
+	if (!handle_executors_for_phase(opts, env->envp, iface, up, phase))
+		return false;
 
-	if (!handle_commands_for_phase(opts, envp, iface, phase))
-		goto handle_error;
+	if (!handle_commands_for_phase(opts, env->envp, iface, phase))
+		return false;
 
 	/* if we don't need to support /etc/network/if-X.d we're done here */
 	if (!lif_config.allow_addon_scripts)
-		goto out_free;
+		return true;
 
 	/* Check if scripts dir for this phase is present and bail out if it isn't */
 	struct stat dir_stat;
@@ -322,70 +324,159 @@ lif_lifecycle_run_phase(const struct lif_execute_opts *opts, struct lif_interfac
 	snprintf (dir_path, 4096, "/etc/network/if-%s.d", phase);
 
 	if (stat (dir_path, &dir_stat) != 0 || S_ISDIR (dir_stat.st_mode) == 0) {
-		goto out_free;
+		return true;
 	}
 
 	/* we should do error handling here, but ifupdown1 doesn't */
-	lif_execute_fmt(opts, envp, "/bin/run-parts %s", dir_path);
+	lif_execute_fmt(opts, env->envp, "/bin/run-parts %s", dir_path);
 
-out_free:
-	lif_environment_free(&envp);
 	return true;
+}
+
+bool
+lif_lifecycle_run_phase(const struct lif_execute_opts *opts, struct lif_interface *iface, const char *phase, const char *lifname, bool up)
+{
+	struct lif_environment env;
 
-handle_error:
-	lif_environment_free(&envp);
-	return false;
+	build_environment(&env, opts, iface, lifname, phase, up ? "start" : "stop");
+
+	bool ret = run_phase(opts, &env, iface, phase, up);
+
+	lif_environment_fini(&env);
+
+	return ret;
 }
 
-/* this function returns true if we can skip processing the interface for now,
- * otherwise false.
+/* this function sets *skip if we can skip processing the interface for now,
+ * and returns false if the state could not be updated.
  */
 static bool
-handle_refcounting(struct lif_dict *state, struct lif_interface *iface, bool up)
+handle_refcounting(struct lif_dict *state, struct lif_interface *iface, bool up, bool *skip)
 {
 	size_t orig_refcount = iface->refcount;
 
-	if (up)
-		lif_state_ref_if(state, iface->ifname, iface);
-	else
-		lif_state_unref_if(state, iface->ifname, iface);
+	bool ok = up ? lif_state_ref_if(state, iface->ifname, iface) : lif_state_unref_if(state, iface->ifname, iface);
+	if (!ok)
+		return false;
 
 #ifdef DEBUG_REFCOUNTING
 	fprintf(stderr, "handle_refcounting(): orig_refcount=%zu, refcount=%zu, direction=%s\n",
 		orig_refcount, iface->refcount, up ? "UP" : "DOWN");
 #endif
 
-	/* if going up and orig_refcount > 0 -- we're already configured. */
-	if (up && orig_refcount > 0)
+	/* if going up and orig_refcount > 0 -- we're already configured.
+	 * if going down and iface->refcount > 1 -- we still have other dependents.
+	 * otherwise we can change this interface -- no blocking dependents.
+	 */
+	*skip = (up && orig_refcount > 0) || (!up && iface->refcount > 1);
+	return true;
+}
+
+/* returns the timeout in seconds configured by a wait option on an interface,
+ * or 0 if the option is not set.
+ */
+static int
+wait_timeout(const struct lif_interface *iface, const char *key)
+{
+	/* the range of the timeout was validated when the configuration was loaded */
+	const struct lif_value *value = lif_value_get(lif_interface_find_var(iface, key), LIF_VALUE_INTEGER);
+
+	return value != NULL ? value->integer : 0;
+}
+
+static void
+handle_carrier_waits(const struct lif_execute_opts *opts, const struct lif_interface *parent, struct lif_netlink_carrier_wait *waits, size_t count)
+{
+	if (opts->mock)
+	{
+		for (size_t i = 0; i < count; i++)
+			fprintf(stderr, "ifupdown: %s: would wait up to %d seconds for carrier on %s\n",
+				parent->ifname, waits[i].timeout, waits[i].ifname);
+
+		return;
+	}
+
+	if (opts->verbose)
+		fprintf(stderr, "ifupdown: %s: waiting for carrier on %zu dependent interface(s)\n",
+			parent->ifname, count);
+
+	if (!lif_netlink_wait_carrier(waits, count))
+	{
+		fprintf(stderr, "ifupdown: %s: unable to monitor carrier of dependent interfaces: %s\n",
+			parent->ifname, strerror(errno));
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		if (waits[i].has_carrier)
+			continue;
+
+		fprintf(stderr, "ifupdown: %s: no carrier on %s after %d seconds, continuing anyway\n",
+			parent->ifname, waits[i].ifname, waits[i].timeout);
+	}
+}
+
+static bool
+handle_dad_wait(const struct lif_execute_opts *opts, const struct lif_interface *iface, const char *lifname)
+{
+	int timeout = wait_timeout(iface, "ipv6-dad-wait");
+
+	if (!timeout)
 		return true;
 
-	/* if going down and iface->refcount > 1 -- we still have other dependents. */
-	if (!up && iface->refcount > 1)
+	if (opts->mock)
+	{
+		fprintf(stderr, "ifupdown: %s: would wait up to %d seconds for IPv6 duplicate address detection\n",
+			lifname, timeout);
 		return true;
+	}
+
+	if (opts->verbose)
+		fprintf(stderr, "ifupdown: %s: waiting for IPv6 duplicate address detection\n", lifname);
+
+	char failed_addr[64] = "";
 
-	/* we can change this interface -- no blocking dependents. */
-	return false;
+	switch (lif_netlink_wait_dad(lifname, timeout, failed_addr, sizeof failed_addr))
+	{
+	case LIF_NETLINK_DAD_COMPLETE:
+		return true;
+	case LIF_NETLINK_DAD_FAILED:
+		fprintf(stderr, "ifupdown: %s: duplicate address detection failed for %s\n",
+			lifname, failed_addr);
+		return false;
+	case LIF_NETLINK_DAD_TIMEOUT:
+		fprintf(stderr, "ifupdown: %s: duplicate address detection still in progress after %d seconds, continuing anyway\n",
+			lifname, timeout);
+		return true;
+	case LIF_NETLINK_DAD_ERROR:
+	default:
+		fprintf(stderr, "ifupdown: %s: unable to monitor duplicate address detection: %s\n",
+			lifname, strerror(errno));
+		return true;
+	}
 }
 
 static bool
 handle_dependents(const struct lif_execute_opts *opts, struct lif_interface *parent, struct lif_dict *collection, struct lif_dict *state, bool up)
 {
-	struct lif_dict_entry *requires = lif_dict_find(&parent->vars, "requires");
+	if (!lif_interface_resolve_requires(collection, parent))
+		return false;
 
 	/* no dependents, nothing to worry about */
-	if (requires == NULL)
+	if (!parent->requires_count)
 		return true;
 
 	/* set the parent's pending flag to break dependency cycles */
 	parent->is_pending = true;
 
-	char require_ifs[4096] = {};
-	strlcpy(require_ifs, requires->data, sizeof require_ifs);
-	char *bufp = require_ifs;
+	/* dependents which must have carrier before the parent is configured */
+	struct lif_netlink_carrier_wait *carrier_waits = NULL;
+	size_t carrier_wait_count = 0;
 
-	for (char *tokenp = lif_next_token(&bufp); *tokenp; tokenp = lif_next_token(&bufp))
+	for (size_t i = 0; i < parent->requires_count; i++)
 	{
-		struct lif_interface *iface = lif_interface_collection_find(collection, tokenp);
+		struct lif_interface *iface = parent->requires[i];
 
 		if (iface->has_config_error)
 		{
@@ -400,11 +491,36 @@ handle_dependents(const struct lif_execute_opts *opts, struct lif_interface *par
 			}
 		}
 
-		/* if handle_refcounting returns true, it means we've already
+		int carrier_timeout = up ? wait_timeout(iface, "wait-carrier") : 0;
+		if (carrier_timeout > 0)
+		{
+			struct lif_netlink_carrier_wait *waits = realloc(carrier_waits, (carrier_wait_count + 1) * sizeof *waits);
+
+			if (waits != NULL)
+			{
+				carrier_waits = waits;
+				carrier_waits[carrier_wait_count++] = (struct lif_netlink_carrier_wait) {
+					.ifname = iface->ifname,
+					.timeout = carrier_timeout,
+				};
+			}
+		}
+
+		/* if handle_refcounting sets skip, it means we've already
 		 * configured the interface, or it is too soon to deconfigure
 		 * the interface.
 		 */
-		if (handle_refcounting(state, iface, up))
+		bool skip;
+
+		if (!handle_refcounting(state, iface, up, &skip))
+		{
+			fprintf(stderr, "ifupdown: %s: could not update the state: %s\n", iface->ifname, strerror(errno));
+			free(carrier_waits);
+			parent->is_pending = false;
+			return false;
+		}
+
+		if (skip)
 		{
 			if (opts->verbose)
 				fprintf(stderr, "ifupdown: skipping dependent interface %s (of %s) -- %s\n",
@@ -429,11 +545,20 @@ handle_dependents(const struct lif_execute_opts *opts, struct lif_interface *par
 
 		if (!lif_lifecycle_run(opts, iface, collection, state, iface->ifname, up))
 		{
+			free(carrier_waits);
 			parent->is_pending = false;
 			return false;
 		}
 	}
 
+	/* all dependents have been configured, now block until the ones
+	 * which asked for it have carrier.  waiting here rather than right
+	 * after each dependent allows the links to negotiate in parallel.
+	 */
+	if (carrier_wait_count > 0)
+		handle_carrier_waits(opts, parent, carrier_waits, carrier_wait_count);
+
+	free(carrier_waits);
 	parent->is_pending = false;
 	return true;
 }
@@ -451,95 +576,272 @@ lif_lifecycle_run(const struct lif_execute_opts *opts, struct lif_interface *ifa
 	if (lifname == NULL)
 		lifname = iface->ifname;
 
+	struct lif_environment env;
+	bool ret = false;
+
 	if (up)
 	{
+		if (!lif_state_can_record(opts->state_file, lifname, iface->ifname))
+		{
+			fprintf(stderr, "ifupdown: %s: interface name is too long to be recorded in the state file\n", lifname);
+			return false;
+		}
+
 		/* when going up, dependents go up first. */
 		if (!handle_dependents(opts, iface, collection, state, up))
 			return false;
 
+		/* the environment is the same for every phase, apart from PHASE and MODE */
+		build_environment(&env, opts, iface, lifname, "create", "start");
+
 		/* XXX: we should try to recover (take the iface down) if bringing it up fails.
 		 * but, right now neither debian ifupdown or busybox ifupdown do any recovery,
 		 * so we wont right now.
 		 */
-		if (!lif_lifecycle_run_phase(opts, iface, "create", lifname, up))
-			return false;
+		if (!run_phase(opts, &env, iface, "create", up))
+			goto out;
 
-		if (!lif_lifecycle_run_phase(opts, iface, "pre-up", lifname, up))
-			return false;
+		if (!run_phase(opts, &env, iface, "pre-up", up))
+			goto out;
 
-		if (!lif_lifecycle_run_phase(opts, iface, "up", lifname, up))
-			return false;
+		if (!run_phase(opts, &env, iface, "up", up))
+			goto out;
 
-		if (!lif_lifecycle_run_phase(opts, iface, "post-up", lifname, up))
-			return false;
+		/* addresses must be usable before post-up hooks try to bind them. */
+		if (!handle_dad_wait(opts, iface, lifname))
+			goto out;
+
+		if (!run_phase(opts, &env, iface, "post-up", up))
+			goto out;
 
-		lif_state_ref_if(state, lifname, iface);
+		iface->fingerprint = lif_interface_fingerprint(iface);
+		if (!lif_state_ref_if(state, lifname, iface))
+		{
+			fprintf(stderr, "ifupdown: %s: could not update the state: %s\n", lifname, strerror(errno));
+			goto out;
+		}
 	}
 	else
 	{
-		if (!lif_lifecycle_run_phase(opts, iface, "pre-down", lifname, up))
-			return false;
+		build_environment(&env, opts, iface, lifname, "pre-down", "stop");
 
-		if (!lif_lifecycle_run_phase(opts, iface, "down", lifname, up))
-			return false;
+		if (!run_phase(opts, &env, iface, "pre-down", up))
+			goto out;
 
-		if (!lif_lifecycle_run_phase(opts, iface, "post-down", lifname, up))
-			return false;
+		if (!run_phase(opts, &env, iface, "down", up))
+			goto out;
 
-		if (!lif_lifecycle_run_phase(opts, iface, "destroy", lifname, up))
-			return false;
+		if (!run_phase(opts, &env, iface, "post-down", up))
+			goto out;
+
+		if (!run_phase(opts, &env, iface, "destroy", up))
+			goto out;
 
 		/* when going up, dependents go down last. */
 		if (!handle_dependents(opts, iface, collection, state, up))
-			return false;
+			goto out;
 
-		lif_state_unref_if(state, lifname, iface);
+		if (!lif_state_unref_if(state, lifname, iface))
+		{
+			fprintf(stderr, "ifupdown: %s: could not update the state: %s\n", lifname, strerror(errno));
+			goto out;
+		}
 	}
 
-	return true;
+	ret = true;
+
+out:
+	lif_environment_fini(&env);
+	return ret;
+}
+
+/*
+ * The dependency graph has an edge from every interface to each interface
+ * it requires.  An interface's rdepends_count is the length of the longest
+ * path reaching it from an interface nothing depends on, so the collection
+ * can be ordered with dependents first by sorting on it.
+ */
+struct dependency_graph {
+	struct lif_interface **ifaces;	/* indexed by interface id */
+	size_t count;
+
+	size_t *indegree;		/* unprocessed interfaces requiring each interface */
+	size_t *rev_start;		/* reverse edges of interface i are rev[rev_start[i]..rev_start[i + 1]] */
+	size_t *rev;
+	size_t *queue;
+};
+
+static void
+dependency_graph_fini(struct dependency_graph *graph)
+{
+	free(graph->ifaces);
+	free(graph->indegree);
+	free(graph->rev_start);
+	free(graph->rev);
+	free(graph->queue);
 }
 
 static bool
-count_interface_rdepends(const struct lif_execute_opts *opts, struct lif_dict *collection, struct lif_interface *parent, size_t depth)
+dependency_graph_init(struct dependency_graph *graph, struct lif_dict *collection)
 {
-	/* if we have looped, return true immediately to break the loop. */
-	if (parent->is_pending)
-		return true;
+	struct lif_node *iter;
+	size_t edges = 0;
+
+	memset(graph, 0, sizeof *graph);
 
-	/* query our dependents if we don't have them already */
-	if (!lif_lifecycle_query_dependents(opts, parent, parent->ifname))
+	graph->count = collection->list.length;
+	graph->ifaces = calloc(graph->count, sizeof *graph->ifaces);
+	graph->indegree = calloc(graph->count, sizeof *graph->indegree);
+	graph->rev_start = calloc(graph->count + 1, sizeof *graph->rev_start);
+	graph->queue = calloc(graph->count, sizeof *graph->queue);
+
+	if (graph->ifaces == NULL || graph->indegree == NULL || graph->rev_start == NULL || graph->queue == NULL)
 		return false;
 
-	/* set rdepends_count to depth, dependents will be depth + 1 */
-	parent->is_pending = true;
-	parent->rdepends_count = depth;
+	LIF_DICT_FOREACH(iter, collection)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_interface *iface = entry->data;
 
-	struct lif_dict_entry *requires = lif_dict_find(&parent->vars, "requires");
+		graph->ifaces[iface->id] = iface;
+		iface->rdepends_count = 0;
 
-	/* no dependents, nothing to worry about */
-	if (requires == NULL)
+		for (size_t i = 0; i < iface->requires_count; i++)
+		{
+			graph->indegree[iface->requires[i]->id]++;
+			edges++;
+		}
+	}
+
+	graph->rev = calloc(edges ? edges : 1, sizeof *graph->rev);
+	if (graph->rev == NULL)
+		return false;
+
+	for (size_t id = 0; id < graph->count; id++)
+		graph->rev_start[id + 1] = graph->rev_start[id] + graph->indegree[id];
+
+	/* fill the reverse edges, using rev_start[id + 1] as a cursor that ends up where it began */
+	for (size_t id = 0; id < graph->count; id++)
 	{
-		parent->is_pending = false;
-		return true;
+		const struct lif_interface *iface = graph->ifaces[id];
+
+		for (size_t i = 0; i < iface->requires_count; i++)
+			graph->rev[--graph->rev_start[iface->requires[i]->id + 1]] = id;
 	}
 
-	/* walk any dependents */
-	char require_ifs[4096] = {};
-	strlcpy(require_ifs, requires->data, sizeof require_ifs);
-	char *bufp = require_ifs;
+	for (size_t id = 0; id < graph->count; id++)
+		graph->rev_start[id + 1] = graph->rev_start[id] + graph->indegree[id];
+
+	return true;
+}
+
+/*
+ * Every interface left unprocessed by Kahn's algorithm is still required by
+ * another unprocessed interface, so following those reverse edges from any
+ * of them must run into a cycle.  Report it, and return the interface at
+ * which to break it: the member of the cycle which was defined last.
+ */
+static size_t
+dependency_graph_break_cycle(const struct dependency_graph *graph, const bool *done, size_t start)
+{
+	size_t *seen = calloc(graph->count, sizeof *seen);
+	size_t *path = calloc(graph->count, sizeof *path);
+	size_t len = 0, id = start;
 
-	for (char *tokenp = lif_next_token(&bufp); *tokenp; tokenp = lif_next_token(&bufp))
+	if (seen == NULL || path == NULL)
 	{
-		struct lif_interface *iface = lif_interface_collection_find(collection, tokenp);
+		free(seen);
+		free(path);
+		return start;
+	}
+
+	/* seen[id] is the position of id on the path plus one */
+	while (!seen[id])
+	{
+		path[len++] = id;
+		seen[id] = len;
 
-		if (!count_interface_rdepends(opts, collection, iface, depth + 1))
+		for (size_t i = graph->rev_start[id]; i < graph->rev_start[id + 1]; i++)
 		{
-			parent->is_pending = false;
-			return false;
+			if (!done[graph->rev[i]])
+			{
+				id = graph->rev[i];
+				break;
+			}
 		}
 	}
 
-	parent->is_pending = false;
+	/* the path was walked against the requires edges, print it along them */
+	size_t first = seen[id] - 1, breaker = id;
+
+	fprintf(stderr, "ifupdown: dependency loop detected: %s", graph->ifaces[id]->ifname);
+
+	for (size_t i = len; i-- > first;)
+	{
+		fprintf(stderr, " -> %s", graph->ifaces[path[i]]->ifname);
+
+		if (path[i] > breaker)
+			breaker = path[i];
+	}
+
+	fprintf(stderr, "\n");
+
+	free(seen);
+	free(path);
+
+	return breaker;
+}
+
+static bool
+dependency_graph_order(struct dependency_graph *graph)
+{
+	size_t head = 0, tail = 0, scan = 0;
+	bool *done = calloc(graph->count, sizeof *done);
+
+	if (done == NULL)
+		return false;
+
+	for (size_t id = 0; id < graph->count; id++)
+	{
+		if (!graph->indegree[id])
+			graph->queue[tail++] = id;
+	}
+
+	while (head < graph->count)
+	{
+		if (head == tail)
+		{
+			/* only cycles are left, break one at an interface still waiting */
+			while (done[scan] || !graph->indegree[scan])
+				scan++;
+
+			size_t id = dependency_graph_break_cycle(graph, done, scan);
+
+			graph->indegree[id] = 0;
+			graph->queue[tail++] = id;
+		}
+
+		size_t id = graph->queue[head++];
+		struct lif_interface *iface = graph->ifaces[id];
+
+		done[id] = true;
+
+		for (size_t i = 0; i < iface->requires_count; i++)
+		{
+			struct lif_interface *child = iface->requires[i];
+
+			if (done[child->id])
+				continue;
+
+			if (child->rdepends_count < iface->rdepends_count + 1)
+				child->rdepends_count = iface->rdepends_count + 1;
+
+			if (!--graph->indegree[child->id])
+				graph->queue[tail++] = child->id;
+		}
+	}
+
+	free(done);
 	return true;
 }
 
@@ -548,64 +850,136 @@ lif_lifecycle_count_rdepends(const struct lif_execute_opts *opts, struct lif_dic
 {
 	struct lif_node *iter;
 
+	/* learn and resolve the dependencies of every interface, placeholders
+	 * created along the way are appended to the collection and visited too.
+	 */
 	LIF_DICT_FOREACH(iter, collection)
 	{
 		struct lif_dict_entry *entry = iter->data;
 		struct lif_interface *iface = entry->data;
 
-		/* start depth at interface's rdepends_count, which will be 0 for the root,
-		 * but will be more if additional rdepends are found...
-		 */
-		if (!count_interface_rdepends(opts, collection, iface, iface->rdepends_count))
+		if (!lif_lifecycle_query_dependents(opts, collection, iface, iface->ifname) ||
+		    !lif_interface_resolve_requires(collection, iface))
 		{
 			fprintf(stderr, "ifupdown: dependency graph is broken for interface %s\n", iface->ifname);
 			return -1;
 		}
 	}
 
-	/* figure out the max depth */
+	struct dependency_graph graph;
+
+	if (!dependency_graph_init(&graph, collection) || !dependency_graph_order(&graph))
+	{
+		fprintf(stderr, "ifupdown: could not allocate dependency graph: %s\n", strerror(errno));
+		dependency_graph_fini(&graph);
+		return -1;
+	}
+
+	/* stable counting sort of the collection by depth, dependents first */
 	size_t maxdepth = 0;
 
-	LIF_DICT_FOREACH(iter, collection)
+	for (size_t id = 0; id < graph.count; id++)
 	{
-		struct lif_dict_entry *entry = iter->data;
-		struct lif_interface *iface = entry->data;
+		if (graph.ifaces[id]->rdepends_count > maxdepth)
+			maxdepth = graph.ifaces[id]->rdepends_count;
+	}
 
-		if (iface->rdepends_count > maxdepth)
-			maxdepth = iface->rdepends_count;
+	struct lif_list *buckets = calloc(maxdepth + 1, sizeof *buckets);
+	if (buckets == NULL)
+	{
+		dependency_graph_fini(&graph);
+		return -1;
 	}
 
-	/* move the collection to a temporary list so we can reorder it */
-	struct lif_list temp_list = {};
 	struct lif_node *iter_next;
 
 	LIF_LIST_FOREACH_SAFE(iter, iter_next, collection->list.head)
 	{
-		void *data = iter->data;
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_interface *iface = entry->data;
 
 		lif_node_delete(iter, &collection->list);
 		memset(iter, 0, sizeof *iter);
 
-		lif_node_insert(iter, data, &temp_list);
+		lif_node_insert_tail(iter, entry, &buckets[iface->rdepends_count]);
 	}
 
-	/* walk backwards from maxdepth to 0, readding nodes */
-	for (ssize_t curdepth = maxdepth; curdepth > -1; curdepth--)
+	for (size_t depth = 0; depth <= maxdepth; depth++)
 	{
-		LIF_LIST_FOREACH_SAFE(iter, iter_next, temp_list.head)
+		LIF_LIST_FOREACH_SAFE(iter, iter_next, buckets[depth].head)
 		{
-			struct lif_dict_entry *entry = iter->data;
-			struct lif_interface *iface = entry->data;
-
-			if ((ssize_t) iface->rdepends_count != curdepth)
-				continue;
+			void *data = iter->data;
 
-			lif_node_delete(iter, &temp_list);
+			lif_node_delete(iter, &buckets[depth]);
 			memset(iter, 0, sizeof *iter);
 
-			lif_node_insert(iter, entry, &collection->list);
+			lif_node_insert_tail(iter, data, &collection->list);
 		}
 	}
 
+	free(buckets);
+	dependency_graph_fini(&graph);
+
 	return maxdepth;
 }
+
+/*
+ * Learn and resolve the dependencies of the given interfaces and of
+ * everything they require, leaving the rest of the collection alone.
+ * This is all the lifecycle needs to change the state of a few
+ * interfaces; only ordering the whole collection needs the full graph.
+ */
+bool
+lif_lifecycle_resolve_closure(const struct lif_execute_opts *opts, struct lif_dict *collection, struct lif_interface **ifaces, size_t count)
+{
+	struct lif_interface **work = calloc(count ? count : 1, sizeof *work);
+	size_t work_len = 0, work_alloc = count ? count : 1;
+	bool ret = true;
+
+	if (work == NULL)
+		return false;
+
+	memcpy(work, ifaces, count * sizeof *work);
+	work_len = count;
+
+	/* resolved interfaces have been visited, so each one is queried once */
+	while (work_len > 0)
+	{
+		struct lif_interface *iface = work[--work_len];
+
+		if (iface->requires_resolved)
+			continue;
+
+		if (!lif_lifecycle_query_dependents(opts, collection, iface, iface->ifname) ||
+		    !lif_interface_resolve_requires(collection, iface))
+		{
+			fprintf(stderr, "ifupdown: dependency graph is broken for interface %s\n", iface->ifname);
+			ret = false;
+			break;
+		}
+
+		if (work_len + iface->requires_count > work_alloc)
+		{
+			size_t alloc = work_alloc * 2 > work_len + iface->requires_count ? work_alloc * 2 : work_len + iface->requires_count;
+			struct lif_interface **new_work = realloc(work, alloc * sizeof *new_work);
+
+			if (new_work == NULL)
+			{
+				ret = false;
+				break;
+			}
+
+			work = new_work;
+			work_alloc = alloc;
+		}
+
+		for (size_t i = 0; i < iface->requires_count; i++)
+		{
+			if (!iface->requires[i]->requires_resolved)
+				work[work_len++] = iface->requires[i];
+		}
+	}
+
+	free(work);
+	return ret;
+}
@@ -0,0 +1,844 @@
+/*
+ * libifupdown/netlink.c
+ * Purpose: rtnetlink helpers for waiting on kernel link and address state
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "libifupdown/netlink.h"
+
+#if defined(__linux__)
+
+#include <poll.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+
+#ifndef IFF_LOWER_UP
+# define IFF_LOWER_UP	0x10000
+#endif
+
+/* IF_OPER_UP as defined by RFC 2863 */
+#define LIF_OPER_UP	6
+
+#define NETLINK_BUFFER_LEN	32768
+
+static int
+netlink_open(unsigned int groups)
+{
+	int fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+	if (fd < 0)
+		return -1;
+
+	struct sockaddr_nl sa = {
+		.nl_family = AF_NETLINK,
+		.nl_groups = groups,
+	};
+
+	if (bind(fd, (struct sockaddr *) &sa, sizeof sa) < 0)
+	{
+		int saved_errno = errno;
+
+		close(fd);
+		errno = saved_errno;
+		return -1;
+	}
+
+	return fd;
+}
+
+static bool
+netlink_request_dump(int fd, int type, const void *payload, size_t payload_len)
+{
+	char buf[NLMSG_SPACE(64)] = {};
+	struct nlmsghdr *nlh = (struct nlmsghdr *) buf;
+
+	if (NLMSG_SPACE(payload_len) > sizeof buf)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	nlh->nlmsg_len = NLMSG_LENGTH(payload_len);
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	nlh->nlmsg_seq = time(NULL);
+	memcpy(NLMSG_DATA(nlh), payload, payload_len);
+
+	struct sockaddr_nl sa = {
+		.nl_family = AF_NETLINK,
+	};
+
+	return sendto(fd, buf, nlh->nlmsg_len, 0, (struct sockaddr *) &sa, sizeof sa) >= 0;
+}
+
+static bool
+netlink_request_links(int fd)
+{
+	struct ifinfomsg ifi = {
+		.ifi_family = AF_UNSPEC,
+	};
+
+	return netlink_request_dump(fd, RTM_GETLINK, &ifi, sizeof ifi);
+}
+
+static bool
+netlink_request_addresses(int fd, int family)
+{
+	struct ifaddrmsg ifa = {
+		.ifa_family = family,
+	};
+
+	return netlink_request_dump(fd, RTM_GETADDR, &ifa, sizeof ifa);
+}
+
+static int64_t
+monotonic_msec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * A monitor is a netlink socket subscribed to some multicast groups,
+ * together with the snapshot request used to learn the current state
+ * and the handler which processes both the snapshot and any events.
+ */
+struct netlink_monitor {
+	int fd;
+	char *buf;
+	bool (*request)(struct netlink_monitor *mon);
+	void (*handle)(struct netlink_monitor *mon, struct nlmsghdr *nlh);
+	void *ctx;
+};
+
+static bool
+netlink_monitor_open(struct netlink_monitor *mon, unsigned int groups)
+{
+	mon->buf = malloc(NETLINK_BUFFER_LEN);
+	if (mon->buf == NULL)
+		return false;
+
+	/* subscribe before requesting a snapshot so that no transition can be missed */
+	mon->fd = netlink_open(groups);
+	if (mon->fd < 0)
+	{
+		free(mon->buf);
+		return false;
+	}
+
+	if (!mon->request(mon))
+	{
+		int saved_errno = errno;
+
+		free(mon->buf);
+		close(mon->fd);
+		errno = saved_errno;
+		return false;
+	}
+
+	return true;
+}
+
+static void
+netlink_monitor_close(struct netlink_monitor *mon)
+{
+	int saved_errno = errno;
+
+	free(mon->buf);
+	close(mon->fd);
+	errno = saved_errno;
+}
+
+/* wait up to wait_msec for messages and dispatch them, returns false on socket errors */
+static bool
+netlink_monitor_poll(struct netlink_monitor *mon, int64_t wait_msec)
+{
+	struct pollfd pfd = {
+		.fd = mon->fd,
+		.events = POLLIN,
+	};
+
+	int ret = poll(&pfd, 1, wait_msec);
+	if (ret < 0)
+		return errno == EINTR;
+	else if (ret == 0)
+		return true;
+
+	ssize_t len = recv(mon->fd, mon->buf, NETLINK_BUFFER_LEN, 0);
+	if (len < 0)
+	{
+		/* the socket overran, so request a fresh snapshot */
+		if (errno == ENOBUFS)
+			return mon->request(mon);
+
+		return errno == EINTR || errno == EAGAIN;
+	}
+
+	size_t msglen = len;
+	for (struct nlmsghdr *nlh = (struct nlmsghdr *) mon->buf; NLMSG_OK(nlh, msglen); nlh = NLMSG_NEXT(nlh, msglen))
+		mon->handle(mon, nlh);
+
+	return true;
+}
+
+struct carrier_wait_ctx {
+	struct lif_netlink_carrier_wait *waits;
+	size_t count;
+};
+
+static bool
+carrier_wait_request(struct netlink_monitor *mon)
+{
+	return netlink_request_links(mon->fd);
+}
+
+static void
+carrier_wait_handle(struct netlink_monitor *mon, struct nlmsghdr *nlh)
+{
+	struct carrier_wait_ctx *ctx = mon->ctx;
+
+	if (nlh->nlmsg_type != RTM_NEWLINK)
+		return;
+
+	struct ifinfomsg *ifi = NLMSG_DATA(nlh);
+	int attrlen = IFLA_PAYLOAD(nlh);
+	const char *ifname = NULL;
+	uint8_t operstate = 0;
+
+	for (struct rtattr *rta = IFLA_RTA(ifi); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+	{
+		if (rta->rta_type == IFLA_IFNAME)
+			ifname = RTA_DATA(rta);
+		else if (rta->rta_type == IFLA_OPERSTATE)
+			operstate = *(uint8_t *) RTA_DATA(rta);
+	}
+
+	if (ifname == NULL)
+		return;
+
+	if (!(ifi->ifi_flags & IFF_LOWER_UP) && operstate != LIF_OPER_UP)
+		return;
+
+	for (size_t i = 0; i < ctx->count; i++)
+	{
+		if (!strcmp(ctx->waits[i].ifname, ifname))
+			ctx->waits[i].has_carrier = true;
+	}
+}
+
+bool
+lif_netlink_wait_carrier(struct lif_netlink_carrier_wait *waits, size_t count)
+{
+	int64_t start = monotonic_msec();
+	struct carrier_wait_ctx ctx = {
+		.waits = waits,
+		.count = count,
+	};
+	struct netlink_monitor mon = {
+		.request = carrier_wait_request,
+		.handle = carrier_wait_handle,
+		.ctx = &ctx,
+	};
+
+	if (!netlink_monitor_open(&mon, RTMGRP_LINK))
+		return false;
+
+	for (;;)
+	{
+		/* find the nearest deadline of the waits still pending */
+		int64_t wait_msec = -1;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (waits[i].has_carrier)
+				continue;
+
+			int64_t remaining = start + (int64_t) waits[i].timeout * 1000 - monotonic_msec();
+			if (remaining < 0)
+				remaining = 0;
+
+			if (wait_msec == -1 || remaining < wait_msec)
+				wait_msec = remaining;
+		}
+
+		/* nothing left to wait for, or we have run out of time */
+		if (wait_msec <= 0)
+			break;
+
+		if (!netlink_monitor_poll(&mon, wait_msec))
+		{
+			netlink_monitor_close(&mon);
+			return false;
+		}
+	}
+
+	netlink_monitor_close(&mon);
+	return true;
+}
+
+/*
+ * DAD is tracked as the set of IPv6 addresses on the interface which are
+ * still tentative.  The set is seeded from an address dump and updated
+ * from RTM_NEWADDR/RTM_DELADDR notifications; once the dump is complete
+ * and the set is empty, DAD has finished.
+ */
+struct dad_wait_ctx {
+	unsigned int ifindex;
+	struct in6_addr *tentative;
+	size_t tentative_count;
+	size_t tentative_alloc;
+	bool dumped;
+	bool failed;
+	bool oom;		/* a tentative address could not be tracked */
+	char failed_addr[INET6_ADDRSTRLEN];
+};
+
+static ssize_t
+dad_wait_lookup(struct dad_wait_ctx *ctx, const struct in6_addr *addr)
+{
+	for (size_t i = 0; i < ctx->tentative_count; i++)
+	{
+		if (!memcmp(&ctx->tentative[i], addr, sizeof *addr))
+			return i;
+	}
+
+	return -1;
+}
+
+static void
+dad_wait_update(struct dad_wait_ctx *ctx, const struct in6_addr *addr, bool tentative)
+{
+	ssize_t idx = dad_wait_lookup(ctx, addr);
+
+	if (!tentative)
+	{
+		if (idx != -1)
+			ctx->tentative[idx] = ctx->tentative[--ctx->tentative_count];
+
+		return;
+	}
+
+	if (idx != -1)
+		return;
+
+	if (ctx->tentative_count == ctx->tentative_alloc)
+	{
+		size_t alloc = ctx->tentative_alloc ? ctx->tentative_alloc * 2 : 8;
+		struct in6_addr *tentative = realloc(ctx->tentative, alloc * sizeof *tentative);
+
+		if (tentative == NULL)
+		{
+			ctx->oom = true;
+			return;
+		}
+
+		ctx->tentative = tentative;
+		ctx->tentative_alloc = alloc;
+	}
+
+	ctx->tentative[ctx->tentative_count++] = *addr;
+}
+
+static bool
+dad_wait_request(struct netlink_monitor *mon)
+{
+	struct dad_wait_ctx *ctx = mon->ctx;
+
+	ctx->tentative_count = 0;
+	ctx->dumped = false;
+
+	return netlink_request_addresses(mon->fd, AF_INET6);
+}
+
+static void
+dad_wait_handle(struct netlink_monitor *mon, struct nlmsghdr *nlh)
+{
+	struct dad_wait_ctx *ctx = mon->ctx;
+
+	if (nlh->nlmsg_type == NLMSG_DONE)
+	{
+		ctx->dumped = true;
+		return;
+	}
+
+	if (nlh->nlmsg_type != RTM_NEWADDR && nlh->nlmsg_type != RTM_DELADDR)
+		return;
+
+	struct ifaddrmsg *ifa = NLMSG_DATA(nlh);
+	if (ifa->ifa_family != AF_INET6 || ifa->ifa_index != ctx->ifindex)
+		return;
+
+	int attrlen = IFA_PAYLOAD(nlh);
+	const struct in6_addr *local = NULL, *address = NULL;
+	uint32_t flags = ifa->ifa_flags;
+
+	for (struct rtattr *rta = IFA_RTA(ifa); RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen))
+	{
+		if (rta->rta_type == IFA_LOCAL)
+			local = RTA_DATA(rta);
+		else if (rta->rta_type == IFA_ADDRESS)
+			address = RTA_DATA(rta);
+		else if (rta->rta_type == IFA_FLAGS)
+			flags = *(uint32_t *) RTA_DATA(rta);
+	}
+
+	/* with a peer, IFA_ADDRESS is the peer and the address itself is IFA_LOCAL */
+	const struct in6_addr *addr = local != NULL ? local : address;
+	if (addr == NULL)
+		return;
+
+	if (nlh->nlmsg_type == RTM_DELADDR)
+	{
+		dad_wait_update(ctx, addr, false);
+		return;
+	}
+
+	if (flags & IFA_F_DADFAILED)
+	{
+		ctx->failed = true;
+		inet_ntop(AF_INET6, addr, ctx->failed_addr, sizeof ctx->failed_addr);
+		return;
+	}
+
+	/* optimistic addresses are usable while DAD is still in progress */
+	dad_wait_update(ctx, addr, (flags & IFA_F_TENTATIVE) && !(flags & IFA_F_OPTIMISTIC));
+}
+
+enum lif_netlink_dad_result
+lif_netlink_wait_dad(const char *ifname, int timeout, char *failed_addr, size_t failed_addr_len)
+{
+	int64_t deadline = monotonic_msec() + (int64_t) timeout * 1000;
+	struct dad_wait_ctx ctx = {
+		.ifindex = if_nametoindex(ifname),
+	};
+	struct netlink_monitor mon = {
+		.request = dad_wait_request,
+		.handle = dad_wait_handle,
+		.ctx = &ctx,
+	};
+
+	if (ctx.ifindex == 0)
+		return LIF_NETLINK_DAD_ERROR;
+
+	if (!netlink_monitor_open(&mon, RTMGRP_IPV6_IFADDR))
+		return LIF_NETLINK_DAD_ERROR;
+
+	enum lif_netlink_dad_result result = LIF_NETLINK_DAD_TIMEOUT;
+
+	for (;;)
+	{
+		if (ctx.oom)
+		{
+			errno = ENOMEM;
+			result = LIF_NETLINK_DAD_ERROR;
+			break;
+		}
+
+		if (ctx.failed)
+		{
+			if (failed_addr != NULL)
+				strlcpy(failed_addr, ctx.failed_addr, failed_addr_len);
+
+			result = LIF_NETLINK_DAD_FAILED;
+			break;
+		}
+
+		if (ctx.dumped && ctx.tentative_count == 0)
+		{
+			result = LIF_NETLINK_DAD_COMPLETE;
+			break;
+		}
+
+		int64_t wait_msec = deadline - monotonic_msec();
+		if (wait_msec <= 0)
+			break;
+
+		if (!netlink_monitor_poll(&mon, wait_msec))
+		{
+			result = LIF_NETLINK_DAD_ERROR;
+			break;
+		}
+	}
+
+	free(ctx.tentative);
+	netlink_monitor_close(&mon);
+	return result;
+}
+
+
+/*
+ * Request/response exchanges: dumps and batched modifications.
+ */
+bool
+lif_netlink_open(struct lif_netlink *nl)
+{
+	nl->buf = malloc(NETLINK_BUFFER_LEN);
+	if (nl->buf == NULL)
+		return false;
+
+	nl->fd = netlink_open(0);
+	if (nl->fd < 0)
+	{
+		free(nl->buf);
+		return false;
+	}
+
+	/* acknowledgements need not echo back the whole request */
+	int one = 1;
+	setsockopt(nl->fd, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof one);
+
+	nl->seq = time(NULL);
+	return true;
+}
+
+void
+lif_netlink_close(struct lif_netlink *nl)
+{
+	int saved_errno = errno;
+
+	free(nl->buf);
+	close(nl->fd);
+	errno = saved_errno;
+}
+
+static bool
+netlink_send(struct lif_netlink *nl, const void *buf, size_t len)
+{
+	struct sockaddr_nl sa = {
+		.nl_family = AF_NETLINK,
+	};
+
+	ssize_t ret = sendto(nl->fd, buf, len, 0, (struct sockaddr *) &sa, sizeof sa);
+	if (ret < 0)
+		return false;
+
+	if ((size_t) ret != len)
+	{
+		errno = EMSGSIZE;
+		return false;
+	}
+
+	return true;
+}
+
+bool
+lif_netlink_dump(struct lif_netlink *nl, int type, const void *payload, size_t payload_len, lif_netlink_msg_fn fn, void *ctx)
+{
+	char buf[NLMSG_SPACE(64)] = {};
+	struct nlmsghdr *req = (struct nlmsghdr *) buf;
+
+	if (NLMSG_SPACE(payload_len) > sizeof buf)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	req->nlmsg_len = NLMSG_LENGTH(payload_len);
+	req->nlmsg_type = type;
+	req->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req->nlmsg_seq = ++nl->seq;
+	memcpy(NLMSG_DATA(req), payload, payload_len);
+
+	if (!netlink_send(nl, buf, req->nlmsg_len))
+		return false;
+
+	for (;;)
+	{
+		ssize_t len = recv(nl->fd, nl->buf, NETLINK_BUFFER_LEN, 0);
+		if (len < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		size_t msglen = len;
+		for (struct nlmsghdr *nlh = (struct nlmsghdr *) nl->buf; NLMSG_OK(nlh, msglen); nlh = NLMSG_NEXT(nlh, msglen))
+		{
+			if (nlh->nlmsg_seq != nl->seq)
+				continue;
+
+			if (nlh->nlmsg_type == NLMSG_DONE)
+				return true;
+
+			if (nlh->nlmsg_type == NLMSG_ERROR)
+			{
+				struct nlmsgerr *err = NLMSG_DATA(nlh);
+
+				errno = -err->error;
+				return false;
+			}
+
+			fn(nlh, ctx);
+		}
+	}
+}
+
+static bool
+netlink_batch_reserve(struct lif_netlink_batch *batch, size_t len)
+{
+	if (batch->len + len <= batch->alloc)
+		return true;
+
+	size_t alloc = batch->alloc ? batch->alloc : 4096;
+	while (alloc < batch->len + len)
+		alloc *= 2;
+
+	char *buf = realloc(batch->buf, alloc);
+	if (buf == NULL)
+		return false;
+
+	memset(buf + batch->alloc, 0, alloc - batch->alloc);
+	batch->buf = buf;
+	batch->alloc = alloc;
+	return true;
+}
+
+bool
+lif_netlink_batch_add(struct lif_netlink_batch *batch, int type, int flags, const void *payload, size_t payload_len)
+{
+	if (!netlink_batch_reserve(batch, NLMSG_SPACE(payload_len)))
+		return false;
+
+	struct nlmsghdr *nlh = (struct nlmsghdr *) (batch->buf + batch->len);
+
+	nlh->nlmsg_len = NLMSG_LENGTH(payload_len);
+	nlh->nlmsg_type = type;
+	nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+	memcpy(NLMSG_DATA(nlh), payload, payload_len);
+
+	batch->last = batch->len;
+	batch->len += NLMSG_ALIGN(nlh->nlmsg_len);
+	batch->count++;
+	return true;
+}
+
+bool
+lif_netlink_batch_add_attr(struct lif_netlink_batch *batch, int type, const void *data, size_t len)
+{
+	if (!batch->count)
+	{
+		errno = EINVAL;
+		return false;
+	}
+
+	if (!netlink_batch_reserve(batch, RTA_SPACE(len)))
+		return false;
+
+	struct nlmsghdr *nlh = (struct nlmsghdr *) (batch->buf + batch->last);
+	struct rtattr *rta = (struct rtattr *) (batch->buf + batch->len);
+
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	memcpy(RTA_DATA(rta), data, len);
+
+	nlh->nlmsg_len = NLMSG_ALIGN(nlh->nlmsg_len) + RTA_SPACE(len);
+	batch->len += RTA_SPACE(len);
+	return true;
+}
+
+bool
+lif_netlink_batch_commit(struct lif_netlink *nl, struct lif_netlink_batch *batch, lif_netlink_error_fn fn, void *ctx)
+{
+	if (!batch->count)
+		return true;
+
+	/* number the requests so that acknowledgements can be matched to them */
+	uint32_t first_seq = nl->seq + 1;
+	size_t remaining = batch->len;
+
+	for (struct nlmsghdr *nlh = (struct nlmsghdr *) batch->buf; NLMSG_OK(nlh, remaining); nlh = NLMSG_NEXT(nlh, remaining))
+		nlh->nlmsg_seq = ++nl->seq;
+
+	if (!netlink_send(nl, batch->buf, batch->len))
+		return false;
+
+	size_t pending = batch->count;
+	bool ok = true;
+
+	while (pending)
+	{
+		ssize_t len = recv(nl->fd, nl->buf, NETLINK_BUFFER_LEN, 0);
+		if (len < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		size_t msglen = len;
+		for (struct nlmsghdr *nlh = (struct nlmsghdr *) nl->buf; NLMSG_OK(nlh, msglen); nlh = NLMSG_NEXT(nlh, msglen))
+		{
+			if (nlh->nlmsg_type != NLMSG_ERROR)
+				continue;
+
+			if (nlh->nlmsg_seq < first_seq || nlh->nlmsg_seq > nl->seq)
+				continue;
+
+			pending--;
+
+			struct nlmsgerr *err = NLMSG_DATA(nlh);
+			if (!err->error)
+				continue;
+
+			/* find the request this acknowledgement belongs to */
+			size_t index = nlh->nlmsg_seq - first_seq;
+			size_t reqlen = batch->len;
+			struct nlmsghdr *req = (struct nlmsghdr *) batch->buf;
+
+			while (index--)
+				req = NLMSG_NEXT(req, reqlen);
+
+			if (fn == NULL || !fn(req, -err->error, ctx))
+				ok = false;
+		}
+	}
+
+	return ok;
+}
+
+void
+lif_netlink_batch_foreach(struct lif_netlink_batch *batch, lif_netlink_msg_fn fn, void *ctx)
+{
+	size_t remaining = batch->len;
+
+	for (struct nlmsghdr *nlh = (struct nlmsghdr *) batch->buf; NLMSG_OK(nlh, remaining); nlh = NLMSG_NEXT(nlh, remaining))
+		fn(nlh, ctx);
+}
+
+void
+lif_netlink_batch_fini(struct lif_netlink_batch *batch)
+{
+	free(batch->buf);
+	memset(batch, 0, sizeof *batch);
+}
+
+#else
+
+bool
+lif_netlink_wait_carrier(struct lif_netlink_carrier_wait *waits, size_t count)
+{
+	(void) waits;
+	(void) count;
+
+	errno = ENOSYS;
+	return false;
+}
+
+enum lif_netlink_dad_result
+lif_netlink_wait_dad(const char *ifname, int timeout, char *failed_addr, size_t failed_addr_len)
+{
+	(void) ifname;
+	(void) timeout;
+	(void) failed_addr;
+	(void) failed_addr_len;
+
+	errno = ENOSYS;
+	return LIF_NETLINK_DAD_ERROR;
+}
+
+bool
+lif_netlink_open(struct lif_netlink *nl)
+{
+	(void) nl;
+
+	errno = ENOSYS;
+	return false;
+}
+
+void
+lif_netlink_close(struct lif_netlink *nl)
+{
+	(void) nl;
+}
+
+bool
+lif_netlink_dump(struct lif_netlink *nl, int type, const void *payload, size_t payload_len, lif_netlink_msg_fn fn, void *ctx)
+{
+	(void) nl;
+	(void) type;
+	(void) payload;
+	(void) payload_len;
+	(void) fn;
+	(void) ctx;
+
+	errno = ENOSYS;
+	return false;
+}
+
+bool
+lif_netlink_batch_add(struct lif_netlink_batch *batch, int type, int flags, const void *payload, size_t payload_len)
+{
+	(void) batch;
+	(void) type;
+	(void) flags;
+	(void) payload;
+	(void) payload_len;
+
+	errno = ENOSYS;
+	return false;
+}
+
+bool
+lif_netlink_batch_add_attr(struct lif_netlink_batch *batch, int type, const void *data, size_t len)
+{
+	(void) batch;
+	(void) type;
+	(void) data;
+	(void) len;
+
+	errno = ENOSYS;
+	return false;
+}
+
+bool
+lif_netlink_batch_commit(struct lif_netlink *nl, struct lif_netlink_batch *batch, lif_netlink_error_fn fn, void *ctx)
+{
+	(void) nl;
+	(void) batch;
+	(void) fn;
+	(void) ctx;
+
+	errno = ENOSYS;
+	return false;
+}
+
+void
+lif_netlink_batch_foreach(struct lif_netlink_batch *batch, lif_netlink_msg_fn fn, void *ctx)
+{
+	(void) batch;
+	(void) fn;
+	(void) ctx;
+}
+
+void
+lif_netlink_batch_fini(struct lif_netlink_batch *batch)
+{
+	free(batch->buf);
+	memset(batch, 0, sizeof *batch);
+}
+
+#endif
+
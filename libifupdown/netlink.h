@@ -0,0 +1,87 @@
+/*
+ * libifupdown/netlink.h
+ * Purpose: rtnetlink helpers for waiting on kernel link and address state
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#ifndef LIBIFUPDOWN_NETLINK_H__GUARD
+#define LIBIFUPDOWN_NETLINK_H__GUARD
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+struct nlmsghdr;
+
+/*
+ * A pending wait for carrier on a single interface.  The timeout is
+ * given in seconds, has_carrier is set once IFF_LOWER_UP or operstate
+ * UP has been observed for the interface.
+ */
+struct lif_netlink_carrier_wait {
+	const char *ifname;
+	int timeout;
+	bool has_carrier;
+};
+
+/*
+ * Outcome of waiting for IPv6 duplicate address detection to finish.
+ */
+enum lif_netlink_dad_result {
+	LIF_NETLINK_DAD_COMPLETE,
+	LIF_NETLINK_DAD_FAILED,
+	LIF_NETLINK_DAD_TIMEOUT,
+	LIF_NETLINK_DAD_ERROR,
+};
+
+/*
+ * An rtnetlink socket used for request/response exchanges with the kernel.
+ */
+struct lif_netlink {
+	int fd;
+	uint32_t seq;
+	char *buf;
+};
+
+/*
+ * A batch of rtnetlink requests, sent to the kernel in a single write.
+ * Every request is acknowledged individually; attributes are appended
+ * to the most recently added request.
+ */
+struct lif_netlink_batch {
+	char *buf;
+	size_t len;
+	size_t alloc;
+	size_t last;
+	size_t count;
+};
+
+typedef void (*lif_netlink_msg_fn)(struct nlmsghdr *nlh, void *ctx);
+
+/* called for each request the kernel rejected, returns true if the error may be ignored */
+typedef bool (*lif_netlink_error_fn)(const struct nlmsghdr *req, int error, void *ctx);
+
+extern bool lif_netlink_open(struct lif_netlink *nl);
+extern void lif_netlink_close(struct lif_netlink *nl);
+extern bool lif_netlink_dump(struct lif_netlink *nl, int type, const void *payload, size_t payload_len, lif_netlink_msg_fn fn, void *ctx);
+
+extern bool lif_netlink_batch_add(struct lif_netlink_batch *batch, int type, int flags, const void *payload, size_t payload_len);
+extern bool lif_netlink_batch_add_attr(struct lif_netlink_batch *batch, int type, const void *data, size_t len);
+extern bool lif_netlink_batch_commit(struct lif_netlink *nl, struct lif_netlink_batch *batch, lif_netlink_error_fn fn, void *ctx);
+/* calls fn for every message in the batch, e.g. to replay a recorded dump */
+extern void lif_netlink_batch_foreach(struct lif_netlink_batch *batch, lif_netlink_msg_fn fn, void *ctx);
+extern void lif_netlink_batch_fini(struct lif_netlink_batch *batch);
+
+extern bool lif_netlink_wait_carrier(struct lif_netlink_carrier_wait *waits, size_t count);
+extern enum lif_netlink_dad_result lif_netlink_wait_dad(const char *ifname, int timeout, char *failed_addr, size_t failed_addr_len);
+
+#endif
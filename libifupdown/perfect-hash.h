@@ -0,0 +1,54 @@
+/*
+ * libifupdown/perfect-hash.h
+ * Purpose: lookups in generated perfect hash tables
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#ifndef LIBIFUPDOWN_PERFECT_HASH_H__GUARD
+#define LIBIFUPDOWN_PERFECT_HASH_H__GUARD
+
+#include <stdint.h>
+
+/*
+ * Tables of string keyed entries are generated at build time by
+ * tools/perfect-hash, which picks a seed for which no two keys of the
+ * table share a slot.  A lookup is then a single hash and one comparison
+ * against the key of the entry in the slot, which the caller does.
+ */
+struct lif_perfect_hash {
+	uint32_t seed;
+	uint32_t mask;
+	const uint16_t *slots;		/* entry index + 1, or 0 for an empty slot */
+};
+
+static inline uint32_t
+lif_perfect_hash_key(const char *key, uint32_t seed)
+{
+	uint32_t hash = 2166136261u ^ seed;
+
+	for (; *key; key++)
+	{
+		hash ^= (unsigned char) *key;
+		hash *= 16777619u;
+	}
+
+	return hash ^ (hash >> 15);
+}
+
+/* returns the index of the only entry which can match key, or -1 */
+static inline int
+lif_perfect_hash_lookup(const struct lif_perfect_hash *hash, const char *key)
+{
+	return (int) hash->slots[lif_perfect_hash_key(key, hash->seed) & hash->mask] - 1;
+}
+
+#endif
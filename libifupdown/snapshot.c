@@ -0,0 +1,647 @@
+/*
+ * libifupdown/snapshot.c
+ * Purpose: binary snapshots of parsed interface collections
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include "libifupdown/snapshot.h"
+#include "libifupdown/config-file.h"
+#include "libifupdown/interface.h"
+#include "libifupdown/value.h"
+
+#define SNAPSHOT_MAGIC		"LIFSNAP"
+#define SNAPSHOT_VERSION	2
+
+/* values are copied into the snapshot as they are laid out in memory */
+#define SNAPSHOT_ALIGN		16
+
+/*
+ * The snapshot is a header followed by the sections it points to.  All
+ * references are offsets from the start of the snapshot, and the snapshot
+ * is only valid for the build which wrote it, as it contains memory images
+ * of struct lif_address and struct lif_value.
+ */
+struct snapshot_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t address_size;
+	uint32_t value_size;
+	uint64_t size;
+
+	uint64_t config;		/* string identifying the parser configuration */
+	uint64_t files, file_count;
+	uint64_t ifaces, iface_count;
+	uint64_t vars, var_count;
+	uint64_t inherits, inherit_count;
+};
+
+struct snapshot_file {
+	uint64_t path;
+	uint64_t dev, ino, size;
+	int64_t mtime_sec, mtime_nsec;
+	int64_t ctime_sec, ctime_nsec;
+};
+
+#define SNAPSHOT_IFACE_AUTO		0x01
+#define SNAPSHOT_IFACE_BRIDGE		0x02
+#define SNAPSHOT_IFACE_BOND		0x04
+#define SNAPSHOT_IFACE_TEMPLATE		0x08
+#define SNAPSHOT_IFACE_EXPLICIT		0x10
+#define SNAPSHOT_IFACE_NO_DEFAULTS	0x20
+#define SNAPSHOT_IFACE_CONFIG_ERROR	0x40
+#define SNAPSHOT_IFACE_RANGE_AUTO	0x80	/* members of the range are auto */
+
+struct snapshot_iface {
+	uint64_t ifname;
+	uint64_t flags;
+	uint64_t first_var, var_count;
+	uint64_t first_inherit, inherit_count;	/* indexes into the interfaces */
+};
+
+struct snapshot_var {
+	uint64_t key;
+	uint64_t data;
+};
+
+#ifndef BUILD_ID
+# define BUILD_ID ""
+#endif
+
+static void
+snapshot_config_key(char *buf, size_t bufsize, const char *interfaces_file)
+{
+	struct utsname un = {};
+
+	/* the hostname is learned for dhcp at parse time */
+	uname(&un);
+
+	/* another build may parse differently, even if its structures have the same size */
+	snprintf(buf, bufsize, "%s %s %s %d%d%d%d%d%d%d %s", PACKAGE_VERSION, BUILD_ID, interfaces_file,
+		lif_config.allow_addon_scripts,
+		lif_config.allow_any_iface_as_template,
+		lif_config.auto_executor_selection,
+		lif_config.compat_create_interfaces,
+		lif_config.compat_ifupdown2_bridge_ports_inherit_vlans,
+		lif_config.implicit_template_conversion,
+		lif_config.use_hostname_for_dhcp,
+		un.nodename);
+}
+
+static void
+snapshot_file_stat(struct snapshot_file *file, const struct stat *st)
+{
+	file->dev = st->st_dev;
+	file->ino = st->st_ino;
+	file->size = st->st_size;
+	file->mtime_sec = st->st_mtim.tv_sec;
+	file->mtime_nsec = st->st_mtim.tv_nsec;
+	file->ctime_sec = st->st_ctim.tv_sec;
+	file->ctime_nsec = st->st_ctim.tv_nsec;
+}
+
+/*
+ * Writing.
+ */
+struct snapshot_buf {
+	char *data;
+	size_t len;
+	size_t size;
+	bool failed;
+};
+
+static uint64_t
+buf_append(struct snapshot_buf *buf, const void *data, size_t len, size_t align)
+{
+	size_t off = (buf->len + align - 1) & ~(align - 1);
+
+	if (off + len > buf->size)
+	{
+		size_t size = buf->size ? buf->size : 65536;
+
+		while (off + len > size)
+			size *= 2;
+
+		char *newdata = realloc(buf->data, size);
+		if (newdata == NULL)
+		{
+			buf->failed = true;
+			return 0;
+		}
+
+		buf->data = newdata;
+		buf->size = size;
+	}
+
+	memset(buf->data + buf->len, 0, off - buf->len);
+	memcpy(buf->data + off, data, len);
+	buf->len = off + len;
+
+	return off;
+}
+
+static uint64_t
+buf_append_string(struct snapshot_buf *buf, const char *str)
+{
+	return buf_append(buf, str, strlen(str) + 1, 1);
+}
+
+static uint64_t
+buf_append_value(struct snapshot_buf *buf, const struct lif_dict_entry *entry)
+{
+	if (!strcmp(entry->key, "address"))
+		return buf_append(buf, entry->data, sizeof(struct lif_address), SNAPSHOT_ALIGN);
+
+	if (lif_value_type_of(entry->key) == LIF_VALUE_STRING)
+		return buf_append_string(buf, entry->data);
+
+	const struct lif_value *value = entry->data;
+	return buf_append(buf, value, sizeof *value + strlen(value->text) + 1, SNAPSHOT_ALIGN);
+}
+
+/* grows an array of fixed size elements, which is copied into the snapshot at the end */
+static void *
+array_push(void **array, size_t *count, size_t *capacity, size_t elemsize)
+{
+	if (*count == *capacity)
+	{
+		size_t newcap = *capacity ? *capacity * 2 : 64;
+		void *newarray = realloc(*array, newcap * elemsize);
+
+		if (newarray == NULL)
+			return NULL;
+
+		*array = newarray;
+		*capacity = newcap;
+	}
+
+	char *elem = (char *) *array + (*count)++ * elemsize;
+	memset(elem, 0, elemsize);
+
+	return elem;
+}
+
+static void
+add_path(struct lif_dict *paths, const char *path)
+{
+	if (lif_dict_find(paths, path) == NULL)
+		lif_dict_add(paths, path, NULL);
+}
+
+/* the files read, plus the directories searched for files to source, so that new files are noticed */
+static void
+collect_paths(struct lif_dict *paths, const struct lif_interface_file_parse_state *state)
+{
+	struct lif_node *iter;
+
+	LIF_DICT_FOREACH(iter, &state->loaded)
+	{
+		const struct lif_dict_entry *entry = iter->data;
+
+		add_path(paths, entry->key);
+	}
+
+	LIF_DICT_FOREACH(iter, &state->watched)
+	{
+		const struct lif_dict_entry *entry = iter->data;
+
+		add_path(paths, entry->key);
+	}
+}
+
+static bool
+snapshot_build(struct snapshot_buf *buf, const struct lif_dict *collection, const struct lif_interface_file_parse_state *state, const char *interfaces_file)
+{
+	struct snapshot_header header = {
+		.magic = SNAPSHOT_MAGIC,
+		.version = SNAPSHOT_VERSION,
+		.header_size = sizeof header,
+		.address_size = sizeof(struct lif_address),
+		.value_size = sizeof(struct lif_value),
+	};
+	char config[8192];
+	struct lif_node *iter;
+	bool ok = false;
+
+	struct snapshot_file *files = NULL;
+	struct snapshot_iface *ifaces = NULL;
+	struct snapshot_var *vars = NULL;
+	uint64_t *inherits = NULL;
+	size_t files_cap = 0, ifaces_cap = 0, vars_cap = 0, inherits_cap = 0;
+	size_t file_count = 0, iface_count = 0, var_count = 0, inherit_count = 0;
+
+	struct lif_dict paths = {};
+
+	buf_append(buf, &header, sizeof header, SNAPSHOT_ALIGN);
+
+	snapshot_config_key(config, sizeof config, interfaces_file);
+	header.config = buf_append_string(buf, config);
+
+	collect_paths(&paths, state);
+
+	LIF_DICT_FOREACH(iter, &paths)
+	{
+		const struct lif_dict_entry *entry = iter->data;
+		struct stat st;
+
+		if (stat(entry->key, &st) < 0)
+			goto out;
+
+		struct snapshot_file *file = array_push((void **) &files, &file_count, &files_cap, sizeof *file);
+		if (file == NULL)
+			goto out;
+
+		snapshot_file_stat(file, &st);
+		file->path = buf_append_string(buf, entry->key);
+	}
+
+	LIF_DICT_FOREACH(iter, collection)
+	{
+		const struct lif_dict_entry *entry = iter->data;
+		const struct lif_interface *iface = entry->data;
+
+		struct snapshot_iface *sif = array_push((void **) &ifaces, &iface_count, &ifaces_cap, sizeof *sif);
+		if (sif == NULL)
+			goto out;
+
+		sif->ifname = buf_append_string(buf, iface->ifname);
+		sif->flags = (iface->is_auto ? SNAPSHOT_IFACE_AUTO : 0) |
+			(iface->is_bridge ? SNAPSHOT_IFACE_BRIDGE : 0) |
+			(iface->is_bond ? SNAPSHOT_IFACE_BOND : 0) |
+			(iface->is_template ? SNAPSHOT_IFACE_TEMPLATE : 0) |
+			(iface->is_explicit ? SNAPSHOT_IFACE_EXPLICIT : 0) |
+			(iface->no_defaults ? SNAPSHOT_IFACE_NO_DEFAULTS : 0) |
+			(iface->has_config_error ? SNAPSHOT_IFACE_CONFIG_ERROR : 0) |
+			(iface->range != NULL && iface->range->is_auto ? SNAPSHOT_IFACE_RANGE_AUTO : 0);
+
+		sif->first_var = var_count;
+		sif->var_count = iface->vars.list.length;
+
+		struct lif_node *var_iter;
+		LIF_DICT_FOREACH(var_iter, &iface->vars)
+		{
+			const struct lif_dict_entry *var_entry = var_iter->data;
+
+			struct snapshot_var *var = array_push((void **) &vars, &var_count, &vars_cap, sizeof *var);
+			if (var == NULL)
+				goto out;
+
+			var->key = buf_append_string(buf, var_entry->key);
+			var->data = buf_append_value(buf, var_entry);
+		}
+
+		sif->first_inherit = inherit_count;
+		sif->inherit_count = iface->inherits_count;
+
+		for (size_t i = 0; i < iface->inherits_count; i++)
+		{
+			uint64_t *parent = array_push((void **) &inherits, &inherit_count, &inherits_cap, sizeof *parent);
+			if (parent == NULL)
+				goto out;
+
+			*parent = iface->inherits[i]->id;
+		}
+	}
+
+	header.file_count = file_count;
+	header.files = buf_append(buf, files, file_count * sizeof *files, SNAPSHOT_ALIGN);
+	header.iface_count = iface_count;
+	header.ifaces = buf_append(buf, ifaces, iface_count * sizeof *ifaces, SNAPSHOT_ALIGN);
+	header.var_count = var_count;
+	header.vars = buf_append(buf, vars, var_count * sizeof *vars, SNAPSHOT_ALIGN);
+	header.inherit_count = inherit_count;
+	header.inherits = buf_append(buf, inherits, inherit_count * sizeof *inherits, SNAPSHOT_ALIGN);
+
+	if (buf->failed)
+		goto out;
+
+	header.size = buf->len;
+	memcpy(buf->data, &header, sizeof header);
+
+	ok = true;
+
+out:
+	lif_dict_fini(&paths);
+	free(files);
+	free(ifaces);
+	free(vars);
+	free(inherits);
+
+	return ok;
+}
+
+/*
+ * Write a snapshot of a freshly parsed collection.  The snapshot is written
+ * to a temporary file which is renamed over the old one, so that readers
+ * never see a partial snapshot.
+ */
+bool
+lif_snapshot_write(const struct lif_dict *collection, const struct lif_interface_file_parse_state *state, const char *path, const char *interfaces_file)
+{
+	struct snapshot_buf buf = {};
+	char tmppath[4096];
+	bool ok = false;
+
+	if (!snapshot_build(&buf, collection, state, interfaces_file))
+		goto out;
+
+	snprintf(tmppath, sizeof tmppath, "%s.XXXXXX", path);
+
+	int fd = mkstemp(tmppath);
+	if (fd < 0)
+		goto out;
+
+	/* the snapshot is also used by unprivileged ifquery */
+	fchmod(fd, 0644);
+
+	size_t written = 0;
+	while (written < buf.len)
+	{
+		ssize_t n = write(fd, buf.data + written, buf.len - written);
+
+		if (n <= 0)
+			break;
+
+		written += n;
+	}
+
+	if (close(fd) < 0 || written < buf.len || rename(tmppath, path) < 0)
+	{
+		unlink(tmppath);
+		goto out;
+	}
+
+	ok = true;
+
+out:
+	free(buf.data);
+	return ok;
+}
+
+/*
+ * Loading.
+ */
+struct snapshot_map {
+	char *base;
+	size_t size;
+};
+
+static bool
+map_range(const struct snapshot_map *map, uint64_t off, uint64_t count, size_t elemsize)
+{
+	if (off > map->size || (elemsize && count > (map->size - off) / elemsize))
+		return false;
+
+	return true;
+}
+
+static const char *
+map_string(const struct snapshot_map *map, uint64_t off)
+{
+	if (off >= map->size || memchr(map->base + off, '\0', map->size - off) == NULL)
+		return NULL;
+
+	return map->base + off;
+}
+
+static void *
+map_value(const struct snapshot_map *map, const char *key, uint64_t off)
+{
+	if (!strcmp(key, "address"))
+	{
+		if (off % SNAPSHOT_ALIGN || !map_range(map, off, 1, sizeof(struct lif_address)))
+			return NULL;
+
+		return map->base + off;
+	}
+
+	enum lif_value_type type = lif_value_type_of(key);
+	if (type == LIF_VALUE_STRING)
+		return (void *) map_string(map, off);
+
+	if (off % SNAPSHOT_ALIGN || !map_range(map, off, 1, sizeof(struct lif_value)))
+		return NULL;
+
+	struct lif_value *value = (struct lif_value *) (map->base + off);
+	if (value->type != type || map_string(map, off + sizeof *value) == NULL)
+		return NULL;
+
+	return value;
+}
+
+static bool
+snapshot_files_current(const struct snapshot_map *map, const struct snapshot_header *header)
+{
+	const struct snapshot_file *files = (const struct snapshot_file *) (map->base + header->files);
+
+	for (uint64_t i = 0; i < header->file_count; i++)
+	{
+		const char *path = map_string(map, files[i].path);
+		struct snapshot_file current = {};
+		struct stat st;
+
+		if (path == NULL || stat(path, &st) < 0)
+			return false;
+
+		snapshot_file_stat(&current, &st);
+		current.path = files[i].path;
+
+		if (memcmp(&current, &files[i], sizeof current))
+			return false;
+	}
+
+	return true;
+}
+
+static bool
+snapshot_header_valid(const struct snapshot_map *map, const char *interfaces_file)
+{
+	const struct snapshot_header *header = (const struct snapshot_header *) map->base;
+	char config[8192];
+
+	if (map->size < sizeof *header ||
+	    memcmp(header->magic, SNAPSHOT_MAGIC, sizeof header->magic) ||
+	    header->version != SNAPSHOT_VERSION ||
+	    header->header_size != sizeof *header ||
+	    header->address_size != sizeof(struct lif_address) ||
+	    header->value_size != sizeof(struct lif_value) ||
+	    header->size != map->size)
+		return false;
+
+	if (header->files % SNAPSHOT_ALIGN || header->ifaces % SNAPSHOT_ALIGN ||
+	    header->vars % SNAPSHOT_ALIGN || header->inherits % SNAPSHOT_ALIGN)
+		return false;
+
+	if (!map_range(map, header->files, header->file_count, sizeof(struct snapshot_file)) ||
+	    !map_range(map, header->ifaces, header->iface_count, sizeof(struct snapshot_iface)) ||
+	    !map_range(map, header->vars, header->var_count, sizeof(struct snapshot_var)) ||
+	    !map_range(map, header->inherits, header->inherit_count, sizeof(uint64_t)))
+		return false;
+
+	const char *snapshot_config = map_string(map, header->config);
+	snapshot_config_key(config, sizeof config, interfaces_file);
+
+	if (snapshot_config == NULL || strcmp(snapshot_config, config))
+		return false;
+
+	return snapshot_files_current(map, header);
+}
+
+static bool
+snapshot_restore(struct lif_dict *collection, const struct snapshot_map *map)
+{
+	const struct snapshot_header *header = (const struct snapshot_header *) map->base;
+	const struct snapshot_iface *sifs = (const struct snapshot_iface *) (map->base + header->ifaces);
+	const struct snapshot_var *vars = (const struct snapshot_var *) (map->base + header->vars);
+	const uint64_t *inherits = (const uint64_t *) (map->base + header->inherits);
+
+	struct lif_interface **ifaces = calloc(header->iface_count ? header->iface_count : 1, sizeof *ifaces);
+	if (ifaces == NULL)
+		return false;
+
+	bool ok = false;
+
+	for (uint64_t i = 0; i < header->iface_count; i++)
+	{
+		const struct snapshot_iface *sif = &sifs[i];
+		const char *ifname = map_string(map, sif->ifname);
+
+		if (ifname == NULL || lif_dict_find(collection, ifname) != NULL)
+			goto out;
+
+		struct lif_interface *iface = lif_interface_collection_insert(collection, (char *) ifname);
+		if (iface == NULL)
+			goto out;
+
+		iface->is_auto = sif->flags & SNAPSHOT_IFACE_AUTO;
+		iface->is_bridge = sif->flags & SNAPSHOT_IFACE_BRIDGE;
+		iface->is_bond = sif->flags & SNAPSHOT_IFACE_BOND;
+		iface->is_template = sif->flags & SNAPSHOT_IFACE_TEMPLATE;
+		iface->is_explicit = sif->flags & SNAPSHOT_IFACE_EXPLICIT;
+		iface->no_defaults = sif->flags & SNAPSHOT_IFACE_NO_DEFAULTS;
+		iface->has_config_error = sif->flags & SNAPSHOT_IFACE_CONFIG_ERROR;
+
+		/* the range itself is parsed again from the name */
+		if (iface->range != NULL)
+			iface->range->is_auto = sif->flags & SNAPSHOT_IFACE_RANGE_AUTO;
+
+		if (sif->first_var > header->var_count || sif->var_count > header->var_count - sif->first_var)
+			goto out;
+
+		for (uint64_t j = sif->first_var; j < sif->first_var + sif->var_count; j++)
+		{
+			const char *key = map_string(map, vars[j].key);
+			if (key == NULL)
+				goto out;
+
+			void *data = map_value(map, key, vars[j].data);
+			if (data == NULL)
+				goto out;
+
+			if (lif_dict_add(&iface->vars, key, data) == NULL)
+				goto out;
+		}
+
+		ifaces[i] = iface;
+	}
+
+	/* all interfaces exist now, so the parents can be linked */
+	for (uint64_t i = 0; i < header->iface_count; i++)
+	{
+		const struct snapshot_iface *sif = &sifs[i];
+		struct lif_interface *iface = ifaces[i];
+
+		if (!sif->inherit_count)
+			continue;
+
+		if (sif->first_inherit > header->inherit_count || sif->inherit_count > header->inherit_count - sif->first_inherit)
+			goto out;
+
+		iface->inherits = lif_dict_alloc(&iface->vars, sif->inherit_count * sizeof *iface->inherits);
+		if (iface->inherits == NULL)
+			goto out;
+
+		for (uint64_t j = 0; j < sif->inherit_count; j++)
+		{
+			uint64_t parent = inherits[sif->first_inherit + j];
+
+			if (parent >= header->iface_count)
+				goto out;
+
+			iface->inherits[j] = ifaces[parent];
+		}
+
+		iface->inherits_count = sif->inherit_count;
+	}
+
+	ok = true;
+
+out:
+	free(ifaces);
+	return ok;
+}
+
+/*
+ * Load a collection from a snapshot, if it exists and was taken from the
+ * current state of the interfaces file.  On success, the collection is
+ * initialized as if the interfaces file was parsed into it.
+ */
+bool
+lif_snapshot_load(struct lif_dict *collection, const char *path, const char *interfaces_file)
+{
+	struct snapshot_map map = {};
+	struct stat st;
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || (size_t) st.st_size < sizeof(struct snapshot_header))
+	{
+		close(fd);
+		return false;
+	}
+
+	/* private and writable, as formatting an address temporarily changes it */
+	map.size = st.st_size;
+	map.base = mmap(NULL, map.size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map.base == MAP_FAILED)
+		return false;
+
+	if (!snapshot_header_valid(&map, interfaces_file))
+	{
+		munmap(map.base, map.size);
+		return false;
+	}
+
+	lif_interface_collection_init_empty(collection);
+
+	if (!snapshot_restore(collection, &map))
+	{
+		lif_interface_collection_fini(collection);
+		munmap(map.base, map.size);
+		return false;
+	}
+
+	return true;
+}
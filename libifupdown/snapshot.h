@@ -0,0 +1,35 @@
+/*
+ * libifupdown/snapshot.h
+ * Purpose: binary snapshots of parsed interface collections
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#ifndef LIBIFUPDOWN_SNAPSHOT_H__GUARD
+#define LIBIFUPDOWN_SNAPSHOT_H__GUARD
+
+#include <stdbool.h>
+#include "libifupdown/dict.h"
+#include "libifupdown/interface-file.h"
+
+/*
+ * A snapshot holds an interface collection as it was parsed, before
+ * compat glue and dependency learning, together with the identity (device,
+ * inode, size and times) of every file and directory it was read from and
+ * the configuration which affects parsing.  A snapshot which still matches
+ * all of them is mapped and used in place of parsing the interfaces file
+ * again: variable values point directly into the mapping, which stays
+ * mapped for the lifetime of the process.
+ */
+extern bool lif_snapshot_load(struct lif_dict *collection, const char *path, const char *interfaces_file);
+extern bool lif_snapshot_write(const struct lif_dict *collection, const struct lif_interface_file_parse_state *state, const char *path, const char *interfaces_file);
+
+#endif
@@ -13,29 +13,176 @@
  * from the use of this software.
  */
 
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "libifupdown/state.h"
+#include "libifupdown/config-file.h"
 #include "libifupdown/fgetline.h"
 #include "libifupdown/tokenize.h"
 
+/*
+ * The binary state file is a header followed by fixed size slots, which
+ * are updated in place through a shared mapping while the file is locked.
+ * A slot is only valid while STATE_SLOT_USED is set: the flags are cleared
+ * before the names of a slot are changed and stored last, so a writer
+ * which dies halfway leaves at most one slot unused, never a torn record.
+ * The refcount of a slot which keeps its names is a single atomic store.
+ *
+ * Integers are in host byte order, as the state file never leaves the
+ * host.  A file which holds nothing but the magic is an empty state.
+ *
+ * Several processes may change the state at once, so a process does not
+ * write back the state it read when it started.  Instead, the changed
+ * records are applied to what the file holds when it is written, with
+ * the file locked for just that long: refcounts are adjusted by how much
+ * this process changed them, and everything else is taken as it is.
+ *
+ * With the journal format, these changes are appended to a text state
+ * file as records whose refcount is signed, such as +1 or -1, which the
+ * reader applies to the record read before.  Once the appended records
+ * take more room than the rest of the file, the file is compacted into a
+ * plain text state again, which starts with a comment holding its size.
+ */
+#define STATE_MAGIC		"LIFSTAT"
+#define STATE_VERSION		1
+#define STATE_NAME_MAX		64
+
+/* slots are added in batches, so that the file is not grown for every interface */
+#define STATE_SLOT_BATCH	32
+
+/* journals smaller than this are never compacted */
+#define STATE_JOURNAL_MIN	16384
+#define STATE_JOURNAL_HEADER	"# snapshot %010zu\n"
+
+struct state_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t slot_size;
+	uint32_t slot_count;
+	uint32_t reserved;
+};
+
+#define STATE_SLOT_USED		0x01
+#define STATE_SLOT_EXPLICIT	0x02
+
+struct state_slot {
+	uint32_t flags;
+	uint32_t refcount;
+	uint64_t fingerprint;
+	char ifname[STATE_NAME_MAX];
+	char mapped_if[STATE_NAME_MAX];
+};
+
+/* adds a record as the state file holds it, which is not a change */
+static bool
+state_load(struct lif_dict *state, const char *ifname, struct lif_interface *iface)
+{
+	if (!lif_state_upsert(state, ifname, iface))
+		return false;
+
+	struct lif_state_record *rec = lif_dict_find(state, ifname)->data;
+	rec->base_refcount = rec->refcount;
+	rec->changed = false;
+
+	return true;
+}
+
+static void
+state_remove(struct lif_dict *state, struct lif_dict_entry *entry)
+{
+	struct lif_state_record *rec = entry->data;
+
+	free(rec->mapped_if);
+	free(rec);
+
+	lif_dict_delete_entry(state, entry);
+}
+
+/* applies a journal record, which changes the refcount of a record by delta */
+static bool
+state_replay(struct lif_dict *state, const char *ifname, struct lif_interface *iface, long delta)
+{
+	struct lif_dict_entry *entry = lif_dict_find(state, ifname);
+	size_t refcount = entry != NULL ? ((struct lif_state_record *) entry->data)->refcount : 0;
+
+	if (delta >= 0)
+		refcount += delta;
+	else if (0UL - (unsigned long) delta < refcount)
+		refcount -= 0UL - (unsigned long) delta;
+	else
+		refcount = 0;
+
+	if (!refcount)
+	{
+		if (entry != NULL)
+			state_remove(state, entry);
+
+		return true;
+	}
+
+	iface->refcount = refcount;
+	return state_load(state, ifname, iface);
+}
+
 bool
 lif_state_read(struct lif_dict *state, FILE *fd)
 {
-	char linebuf[4096];
+	struct lif_line_reader reader;
+	char *line;
+	bool ret = true;
+
+	if (!lif_line_reader_open_stream(&reader, fd))
+		return false;
 
-	while (lif_fgetline(linebuf, sizeof linebuf, fd))
+	while ((line = lif_line_reader_next(&reader)) != NULL)
 	{
-		char *bufp = linebuf;
+		char *bufp = line;
 		char *ifname = lif_next_token(&bufp);
 		char *refcount = lif_next_token(&bufp);
-		char *explicit = lif_next_token(&bufp);
 		size_t rc = 1;
-		char *equals_p = strchr(linebuf, '=');
+		char *equals_p = strchr(line, '=');
 		bool is_explicit = false;
+		uint64_t fingerprint = 0;
+
+		/* blank lines, such as the header of a compacted journal */
+		if (!*ifname)
+			continue;
+
+		/* any remaining fields are optional flags, unknown ones are ignored */
+		for (char *tokenp = *refcount ? lif_next_token(&bufp) : refcount; *tokenp; tokenp = lif_next_token(&bufp))
+		{
+			if (!strcmp(tokenp, "explicit"))
+				is_explicit = true;
+			else if (!strncmp(tokenp, "fingerprint=", sizeof "fingerprint=" - 1))
+				fingerprint = strtoull(tokenp + sizeof "fingerprint=" - 1, NULL, 16);
+		}
+
+		char *mapped_if = ifname;
 
-		if (*explicit && !strcmp(explicit, "explicit"))
-			is_explicit = true;
+		if (equals_p != NULL)
+		{
+			*equals_p++ = '\0';
+			mapped_if = equals_p;
+		}
+
+		if (*refcount == '+' || *refcount == '-')
+		{
+			if (!state_replay(state, ifname, &(struct lif_interface){ .ifname = mapped_if, .is_explicit = is_explicit, .fingerprint = fingerprint },
+					  strtol(refcount, NULL, 10)))
+			{
+				ret = false;
+				break;
+			}
+
+			continue;
+		}
 
 		if (*refcount)
 		{
@@ -45,68 +192,254 @@ lif_state_read(struct lif_dict *state, FILE *fd)
 				rc = 1;
 		}
 
-		if (equals_p == NULL)
+		if (!state_load(state, ifname, &(struct lif_interface){ .ifname = mapped_if, .refcount = rc, .is_explicit = is_explicit, .fingerprint = fingerprint }))
 		{
-			lif_state_upsert(state, ifname, &(struct lif_interface){ .ifname = ifname, .refcount = rc, .is_explicit = is_explicit });
-			continue;
+			ret = false;
+			break;
 		}
+	}
+
+	lif_line_reader_close(&reader);
+	return ret;
+}
+
+/*
+ * Opens and locks the state file.  A state file which is converted is
+ * replaced, so the file is opened again if the path no longer refers to
+ * the file which was locked.
+ */
+static int
+state_open_locked(const char *path, int flags, short type)
+{
+	for (;;)
+	{
+		struct stat fst, pst;
+		struct flock fl = {
+			.l_type = type,
+			.l_whence = SEEK_SET,
+		};
 
-		*equals_p++ = '\0';
-		lif_state_upsert(state, ifname, &(struct lif_interface){ .ifname = equals_p, .refcount = rc, .is_explicit = is_explicit });
+		int fd = open(path, flags | O_CLOEXEC, 0644);
+		if (fd < 0)
+			return -1;
+
+		while (fcntl(fd, F_SETLKW, &fl) == -1)
+		{
+			if (errno != EINTR)
+			{
+				close(fd);
+				return -1;
+			}
+		}
+
+		if (fstat(fd, &fst) == 0 && stat(path, &pst) == 0 &&
+		    fst.st_dev == pst.st_dev && fst.st_ino == pst.st_ino)
+			return fd;
+
+		close(fd);
 	}
+}
 
-	return true;
+static bool
+state_is_binary(int fd)
+{
+	char magic[sizeof STATE_MAGIC];
+
+	return pread(fd, magic, sizeof magic, 0) == sizeof magic && !memcmp(magic, STATE_MAGIC, sizeof magic);
+}
+
+/* returns the slots of a mapped state file, or NULL if it is not a valid one */
+static struct state_slot *
+state_slots(void *map, size_t size, uint32_t *count)
+{
+	struct state_header *header = map;
+
+	if (size < sizeof *header || memcmp(header->magic, STATE_MAGIC, sizeof STATE_MAGIC) ||
+	    header->version != STATE_VERSION || header->slot_size != sizeof(struct state_slot))
+		return NULL;
+
+	*count = __atomic_load_n(&header->slot_count, __ATOMIC_ACQUIRE);
+	if (*count > (size - sizeof *header) / sizeof(struct state_slot))
+		return NULL;
+
+	return (struct state_slot *) (header + 1);
+}
+
+static bool
+slot_names_valid(const struct state_slot *slot)
+{
+	return memchr(slot->ifname, '\0', sizeof slot->ifname) != NULL &&
+	       memchr(slot->mapped_if, '\0', sizeof slot->mapped_if) != NULL;
+}
+
+static bool
+state_read_binary(struct lif_dict *state, int fd)
+{
+	struct stat st;
+
+	if (fstat(fd, &st) == -1)
+		return false;
+
+	/* nothing but the magic */
+	if ((size_t) st.st_size < sizeof(struct state_header))
+		return true;
+
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	uint32_t count;
+	struct state_slot *slots = state_slots(map, st.st_size, &count);
+	bool ret = slots != NULL;
+
+	for (uint32_t i = 0; ret && i < count; i++)
+	{
+		const struct state_slot *slot = &slots[i];
+		uint32_t flags = __atomic_load_n(&slot->flags, __ATOMIC_ACQUIRE);
+
+		if (!(flags & STATE_SLOT_USED) || !slot_names_valid(slot))
+			continue;
+
+		ret = state_load(state, slot->ifname, &(struct lif_interface){
+			.ifname = (char *) slot->mapped_if,
+			.refcount = __atomic_load_n(&slot->refcount, __ATOMIC_RELAXED),
+			.is_explicit = flags & STATE_SLOT_EXPLICIT,
+			.fingerprint = slot->fingerprint,
+		});
+	}
+
+	munmap(map, st.st_size);
+	return ret;
 }
 
 bool
 lif_state_read_path(struct lif_dict *state, const char *path)
 {
-	FILE *fd = fopen(path, "r");
-	bool ret;
+	int fd = state_open_locked(path, O_RDONLY, F_RDLCK);
 
 	/* if file cannot be opened, assume an empty state */
-	if (fd == NULL)
+	if (fd < 0)
 		return true;
 
-	ret = lif_state_read(state, fd);
-	fclose(fd);
+	if (state_is_binary(fd))
+	{
+		bool ret = state_read_binary(state, fd);
+
+		close(fd);
+		return ret;
+	}
+
+	FILE *f = fdopen(fd, "r");
+	if (f == NULL)
+	{
+		close(fd);
+		return false;
+	}
+
+	bool ret = lif_state_read(state, f);
+	fclose(f);
 
 	return ret;
 }
 
-void
+/*
+ * Returns whether a record for ifname, mapped to mapped_if, can be written
+ * to the state file at path.  A binary state file holds names of up to
+ * STATE_NAME_MAX - 1 bytes, so an interface with a longer name is refused
+ * before it is brought up, rather than going missing from the state.
+ */
+bool
+lif_state_can_record(const char *path, const char *ifname, const char *mapped_if)
+{
+	if (strlen(ifname) < STATE_NAME_MAX && strlen(mapped_if) < STATE_NAME_MAX)
+		return true;
+
+	/* as in lif_state_write_path(), a binary state file stays binary, and only regular files are replaced */
+	bool binary = lif_config.state_format == LIF_STATE_FORMAT_BINARY;
+	struct stat st;
+
+	if (path != NULL && stat(path, &st) == 0)
+	{
+		if (!S_ISREG(st.st_mode))
+			return true;
+
+		int fd = open(path, O_RDONLY | O_CLOEXEC);
+		if (fd >= 0)
+		{
+			binary = binary || state_is_binary(fd);
+			close(fd);
+		}
+	}
+
+	if (binary)
+		errno = ENAMETOOLONG;
+
+	return !binary;
+}
+
+bool
 lif_state_ref_if(struct lif_dict *state, const char *ifname, struct lif_interface *iface)
 {
 	iface->refcount++;
-	lif_state_upsert(state, ifname, iface);
+	return lif_state_upsert(state, ifname, iface);
 }
 
-void
+bool
 lif_state_unref_if(struct lif_dict *state, const char *ifname, struct lif_interface *iface)
 {
 	if (iface->refcount == 0)
-		return;
+		return true;
 
 	iface->refcount--;
 
 	if (iface->refcount)
-		lif_state_upsert(state, ifname, iface);
-	else
-		lif_state_delete(state, ifname);
+		return lif_state_upsert(state, ifname, iface);
+
+	lif_state_delete(state, ifname);
+	return true;
 }
 
-void
+bool
 lif_state_upsert(struct lif_dict *state, const char *ifname, struct lif_interface *iface)
 {
-	lif_state_delete(state, ifname);
+	struct lif_dict_entry *entry = lif_dict_find(state, ifname);
+	struct lif_state_record *rec;
+
+	/* an existing record is updated in place, the mapping seldom changes */
+	if (entry != NULL)
+	{
+		rec = entry->data;
+
+		if (strcmp(rec->mapped_if, iface->ifname))
+		{
+			char *mapped_if = strdup(iface->ifname);
+			if (mapped_if == NULL)
+				return false;
+
+			free(rec->mapped_if);
+			rec->mapped_if = mapped_if;
+		}
+	}
+	else
+	{
+		rec = calloc(1, sizeof(*rec));
+		if (rec == NULL)
+			return false;
 
-	struct lif_state_record *rec = calloc(1, sizeof(*rec));
+		rec->mapped_if = strdup(iface->ifname);
+		if (rec->mapped_if == NULL || lif_dict_add(state, ifname, rec) == NULL)
+		{
+			free(rec->mapped_if);
+			free(rec);
+			return false;
+		}
+	}
 
-	rec->mapped_if = strdup(iface->ifname);
 	rec->refcount = iface->refcount;
 	rec->is_explicit = iface->is_explicit;
-
-	lif_dict_add(state, ifname, rec);
+	rec->fingerprint = iface->fingerprint;
+	rec->changed = true;
+	return true;
 }
 
 void
@@ -117,11 +450,81 @@ lif_state_delete(struct lif_dict *state, const char *ifname)
 	if (entry == NULL)
 		return;
 
+	/* kept until the state is written, so that the record is removed from the file too */
 	struct lif_state_record *rec = entry->data;
-	free(rec->mapped_if);
-	free(rec);
+	rec->refcount = 0;
+	rec->changed = true;
+}
 
-	lif_dict_delete_entry(state, entry);
+static void
+state_fini(struct lif_dict *state)
+{
+	struct lif_node *iter, *iter_next;
+
+	LIF_DICT_FOREACH_SAFE(iter, iter_next, state)
+		state_remove(state, iter->data);
+
+	lif_dict_fini(state);
+}
+
+/* the refcount of a changed record, with the changes of this process applied to the current one */
+static size_t
+state_merged_refcount(const struct lif_state_record *rec, size_t current)
+{
+	if (rec->refcount >= rec->base_refcount)
+		return current + (rec->refcount - rec->base_refcount);
+
+	size_t released = rec->base_refcount - rec->refcount;
+
+	return current > released ? current - released : 0;
+}
+
+/* applies the changed records of state to the records read from the state file */
+static bool
+state_merge(struct lif_dict *current, const struct lif_dict *state)
+{
+	struct lif_node *iter;
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (!rec->changed)
+			continue;
+
+		struct lif_dict_entry *cur_entry = lif_dict_find(current, entry->key);
+		struct lif_state_record *cur = cur_entry != NULL ? cur_entry->data : NULL;
+		size_t refcount = state_merged_refcount(rec, cur != NULL ? cur->refcount : 0);
+
+		if (!refcount)
+		{
+			lif_state_delete(current, entry->key);
+			continue;
+		}
+
+		if (!lif_state_upsert(current, entry->key, &(struct lif_interface){
+			.ifname = rec->mapped_if,
+			.refcount = refcount,
+			.is_explicit = rec->is_explicit,
+			.fingerprint = rec->fingerprint,
+		}))
+			return false;
+	}
+
+	return true;
+}
+
+static void
+state_write_flags(const struct lif_state_record *rec, FILE *f)
+{
+	if (rec->is_explicit)
+		fputs(" explicit", f);
+
+	if (rec->fingerprint)
+		fprintf(f, " fingerprint=%016" PRIx64, rec->fingerprint);
+
+	fputc('\n', f);
 }
 
 void
@@ -134,21 +537,481 @@ lif_state_write(const struct lif_dict *state, FILE *f)
 		struct lif_dict_entry *entry = iter->data;
 		struct lif_state_record *rec = entry->data;
 
-		fprintf(f, "%s=%s %zu%s\n", entry->key, rec->mapped_if, rec->refcount,
-			rec->is_explicit ? " explicit" : "");
+		if (!rec->refcount)
+			continue;
+
+		fprintf(f, "%s=%s %zu", entry->key, rec->mapped_if, rec->refcount);
+		state_write_flags(rec, f);
+	}
+}
+
+static void
+slot_store(struct state_slot *slot, const char *ifname, const struct lif_state_record *rec, size_t refcount)
+{
+	uint32_t flags = STATE_SLOT_USED | (rec->is_explicit ? STATE_SLOT_EXPLICIT : 0);
+
+	if (refcount > UINT32_MAX)
+		refcount = UINT32_MAX;
+
+	if (!(slot->flags & STATE_SLOT_USED) || strcmp(slot->ifname, ifname) || strcmp(slot->mapped_if, rec->mapped_if))
+	{
+		__atomic_store_n(&slot->flags, 0, __ATOMIC_RELEASE);
+
+		memset(slot->ifname, 0, sizeof slot->ifname);
+		memset(slot->mapped_if, 0, sizeof slot->mapped_if);
+		strlcpy(slot->ifname, ifname, sizeof slot->ifname);
+		strlcpy(slot->mapped_if, rec->mapped_if, sizeof slot->mapped_if);
+	}
+
+	slot->fingerprint = rec->fingerprint;
+	__atomic_store_n(&slot->refcount, (uint32_t) refcount, __ATOMIC_RELEASE);
+	__atomic_store_n(&slot->flags, flags, __ATOMIC_RELEASE);
+}
+
+static size_t
+state_file_size(uint32_t slot_count)
+{
+	return sizeof(struct state_header) + (size_t) slot_count * sizeof(struct state_slot);
+}
+
+/* slots are added in whole batches, with at least one unused slot to spare */
+static size_t
+state_slot_count(size_t needed)
+{
+	return needed + STATE_SLOT_BATCH - needed % STATE_SLOT_BATCH;
+}
+
+static bool
+state_names_fit(const struct lif_dict *state)
+{
+	struct lif_node *iter;
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (rec->refcount && (strlen(entry->key) >= STATE_NAME_MAX || strlen(rec->mapped_if) >= STATE_NAME_MAX))
+		{
+			errno = ENAMETOOLONG;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Applies the changed records to the slots of a valid binary state file,
+ * which is locked.  If there are not enough unused slots for the records
+ * which are new to the file, nothing is changed and *needed is set to the
+ * number of slots which are needed.
+ */
+static bool
+state_merge_binary(const struct lif_dict *state, int fd, size_t size, size_t *needed)
+{
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	uint32_t count;
+	struct state_slot *slots = state_slots(map, size, &count);
+	struct lif_dict placed = {};
+	struct lif_node *iter;
+	uint32_t free_slot = 0;
+	size_t added = 0;
+	bool ret = false;
+
+	*needed = 0;
+
+	if (slots == NULL)
+		goto out;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		struct state_slot *slot = &slots[i];
+
+		if ((slot->flags & STATE_SLOT_USED) && slot_names_valid(slot) && lif_dict_find(&placed, slot->ifname) == NULL)
+			lif_dict_add(&placed, slot->ifname, slot);
+	}
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (rec->changed && lif_dict_find(&placed, entry->key) == NULL && state_merged_refcount(rec, 0))
+			added++;
+	}
+
+	if (placed.list.length + added > count)
+	{
+		*needed = placed.list.length + added;
+		goto out;
+	}
+
+	/* slots which are used but not placed are torn or duplicate records */
+	for (uint32_t i = 0; i < count; i++)
+	{
+		struct state_slot *slot = &slots[i];
+		struct lif_dict_entry *placed_entry;
+
+		if (!(slot->flags & STATE_SLOT_USED))
+			continue;
+
+		if (!slot_names_valid(slot) || (placed_entry = lif_dict_find(&placed, slot->ifname)) == NULL ||
+		    placed_entry->data != slot)
+			__atomic_store_n(&slot->flags, 0, __ATOMIC_RELEASE);
+	}
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (!rec->changed)
+			continue;
+
+		struct lif_dict_entry *placed_entry = lif_dict_find(&placed, entry->key);
+		struct state_slot *slot = placed_entry != NULL ? placed_entry->data : NULL;
+		size_t refcount = state_merged_refcount(rec, slot != NULL ? __atomic_load_n(&slot->refcount, __ATOMIC_RELAXED) : 0);
+
+		if (!refcount)
+		{
+			if (slot != NULL)
+				__atomic_store_n(&slot->flags, 0, __ATOMIC_RELEASE);
+
+			continue;
+		}
+
+		if (slot == NULL)
+		{
+			while (slots[free_slot].flags & STATE_SLOT_USED)
+				free_slot++;
+
+			slot = &slots[free_slot];
+		}
+
+		slot_store(slot, entry->key, rec, refcount);
+	}
+
+	ret = msync(map, size, MS_SYNC) == 0;
+
+out:
+	lif_dict_fini(&placed);
+	munmap(map, size);
+
+	return ret;
+}
+
+/* stores the records into the slots of a new binary state file */
+static bool
+state_fill_binary(const struct lif_dict *state, int fd, size_t size)
+{
+	void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	uint32_t count, i = 0;
+	struct state_slot *slots = state_slots(map, size, &count);
+	struct lif_node *iter;
+	bool ret = false;
+
+	if (slots == NULL)
+		goto out;
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (!rec->refcount)
+			continue;
+
+		if (i == count)
+			goto out;
+
+		slot_store(&slots[i++], entry->key, rec, rec->refcount);
+	}
+
+	ret = msync(map, size, MS_SYNC) == 0;
+
+out:
+	munmap(map, size);
+	return ret;
+}
+
+/* builds a binary state file next to path and moves it over path, for new and converted state files */
+static bool
+state_create_binary(const struct lif_dict *state, const char *path, uint32_t slot_count)
+{
+	char tmppath[4096];
+	struct state_header header = {
+		.magic = STATE_MAGIC,
+		.version = STATE_VERSION,
+		.slot_size = sizeof(struct state_slot),
+		.slot_count = slot_count,
+	};
+
+	if ((size_t) snprintf(tmppath, sizeof tmppath, "%s.XXXXXX", path) >= sizeof tmppath)
+		return false;
+
+	int fd = mkstemp(tmppath);
+	if (fd < 0)
+		return false;
+
+	bool ret = fchmod(fd, 0644) == 0 &&
+		pwrite(fd, &header, sizeof header, 0) == sizeof header &&
+		ftruncate(fd, state_file_size(slot_count)) == 0 &&
+		state_fill_binary(state, fd, state_file_size(slot_count)) &&
+		rename(tmppath, path) == 0;
+
+	if (!ret)
+		unlink(tmppath);
+
+	close(fd);
+	return ret;
+}
+
+/* slots past the end of the file are zero, so growing it adds unused slots */
+static bool
+state_grow_binary(int fd, size_t needed, size_t *size)
+{
+	size_t count = state_slot_count(needed);
+	struct state_header *mapped;
+
+	if (count > UINT32_MAX || ftruncate(fd, state_file_size(count)) == -1)
+		return false;
+
+	mapped = mmap(NULL, sizeof *mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (mapped == MAP_FAILED)
+		return false;
+
+	__atomic_store_n(&mapped->slot_count, count, __ATOMIC_RELEASE);
+	munmap(mapped, sizeof *mapped);
+
+	*size = state_file_size(count);
+	return true;
+}
+
+static bool
+state_write_binary(const struct lif_dict *state, int fd, size_t size)
+{
+	size_t needed;
+
+	if (!state_names_fit(state))
+		return false;
+
+	if (state_merge_binary(state, fd, size, &needed))
+		return true;
+
+	if (!needed || !state_grow_binary(fd, needed, &size))
+		return false;
+
+	return state_merge_binary(state, fd, size, &needed);
+}
+
+/*
+ * Writes a text state file next to path and moves it over path, so that
+ * it is never seen half written.  A snapshot starts with its own size, so
+ * that the journal appended to it can be measured without reading it.
+ */
+static bool
+state_replace_text(const struct lif_dict *state, const char *path, bool snapshot)
+{
+	char tmppath[4096];
+
+	if ((size_t) snprintf(tmppath, sizeof tmppath, "%s.XXXXXX", path) >= sizeof tmppath)
+		return false;
+
+	int fd = mkstemp(tmppath);
+	if (fd < 0)
+		return false;
+
+	FILE *f = fchmod(fd, 0644) == 0 ? fdopen(fd, "w") : NULL;
+	if (f == NULL)
+	{
+		close(fd);
+		unlink(tmppath);
+		return false;
+	}
+
+	if (snapshot)
+		fprintf(f, STATE_JOURNAL_HEADER, (size_t) 0);
+
+	lif_state_write(state, f);
+
+	if (snapshot)
+	{
+		long size = ftell(f);
+
+		if (size > 0 && fseek(f, 0, SEEK_SET) == 0)
+			fprintf(f, STATE_JOURNAL_HEADER, (size_t) size);
+	}
+
+	bool ret = fflush(f) == 0 && !ferror(f);
+
+	ret = fclose(f) == 0 && ret;
+	ret = ret && rename(tmppath, path) == 0;
+
+	if (!ret)
+		unlink(tmppath);
+
+	return ret;
+}
+
+/*
+ * Appends the changed records to a text state file which is locked, with
+ * a single write and sync, and compacts the file once the journal has
+ * outgrown the snapshot at its start, so that compacting costs no more
+ * than the appends did.
+ */
+static bool
+state_append_journal(const struct lif_dict *state, const char *path, FILE *f)
+{
+	char header[sizeof STATE_JOURNAL_HEADER + 16] = {};
+	struct lif_node *iter;
+	struct stat st;
+	size_t snapshot = 0;
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (!rec->changed)
+			continue;
+
+		fprintf(f, "%s=%s %+lld", entry->key, rec->mapped_if,
+			(long long) rec->refcount - (long long) rec->base_refcount);
+		state_write_flags(rec, f);
+	}
+
+	if (fflush(f) != 0 || fdatasync(fileno(f)) == -1 || fstat(fileno(f), &st) == -1)
+		return false;
+
+	if (pread(fileno(f), header, sizeof header - 1, 0) > 0 && sscanf(header, "# snapshot %zu", &snapshot) != 1)
+		snapshot = 0;
+
+	size_t journal = (size_t) st.st_size > snapshot ? st.st_size - snapshot : 0;
+
+	if (journal <= STATE_JOURNAL_MIN || journal <= snapshot)
+		return true;
+
+	/* the journal is still a valid state if compacting it fails */
+	struct lif_dict current = {};
+
+	rewind(f);
+	if (lif_state_read(&current, f))
+		state_replace_text(&current, path, true);
+
+	state_fini(&current);
+	return true;
+}
+
+static bool
+state_changed(const struct lif_dict *state)
+{
+	struct lif_node *iter;
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		if (rec->changed)
+			return true;
 	}
+
+	return false;
 }
 
 bool
-lif_state_write_path(const struct lif_dict *state, const char *path)
+lif_state_write_path(struct lif_dict *state, const char *path)
 {
-	FILE *fd = fopen(path, "w");
+	struct lif_dict current = {};
+	struct lif_node *iter;
+	struct stat st;
+	FILE *f = NULL;
+	bool ret = false;
 
-	if (fd == NULL)
+	if (!state_changed(state))
+		return true;
+
+	int fd = state_open_locked(path, O_RDWR | O_CREAT, F_WRLCK);
+	if (fd < 0)
 		return false;
 
-	lif_state_write(state, fd);
-	fclose(fd);
+	if (fstat(fd, &st) == -1)
+		goto out;
+
+	/* a binary state file stays binary, and only regular files are replaced */
+	bool regular = S_ISREG(st.st_mode);
+	bool binary = regular && state_is_binary(fd);
+
+	if (binary && (size_t) st.st_size >= sizeof(struct state_header))
+	{
+		ret = state_write_binary(state, fd, st.st_size);
+		goto out;
+	}
+
+	if (regular && !binary && lif_config.state_format == LIF_STATE_FORMAT_JOURNAL)
+	{
+		f = fdopen(fd, "a+");
+		ret = f != NULL && state_append_journal(state, path, f);
+		goto out;
+	}
+
+	/*
+	 * The stream is only closed once the state has been written, as
+	 * closing any descriptor of the file would drop the lock.  A binary
+	 * file which holds nothing but the magic is an empty state.
+	 */
+	if (!binary)
+	{
+		f = fdopen(fd, "r");
+		if (f == NULL || !lif_state_read(&current, f))
+			goto out;
+	}
+
+	if (!state_merge(&current, state))
+		goto out;
+
+	if (regular && (binary || lif_config.state_format == LIF_STATE_FORMAT_BINARY))
+		ret = state_names_fit(&current) &&
+			state_create_binary(&current, path, state_slot_count(current.list.length));
+	else if (regular)
+		ret = state_replace_text(&current, path, false);
+	else
+	{
+		FILE *out = fopen(path, "w");
+
+		if (out != NULL)
+		{
+			lif_state_write(&current, out);
+			ret = fclose(out) == 0;
+		}
+	}
+
+out:
+	state_fini(&current);
+
+	if (f != NULL)
+		fclose(f);
+	else
+		close(fd);
+
+	if (!ret)
+		return false;
+
+	LIF_DICT_FOREACH(iter, state)
+	{
+		struct lif_dict_entry *entry = iter->data;
+		struct lif_state_record *rec = entry->data;
+
+		rec->base_refcount = rec->refcount;
+		rec->changed = false;
+	}
 
 	return true;
 }
@@ -162,12 +1025,11 @@ lif_state_lookup(struct lif_dict *state, struct lif_dict *if_collection, const c
 		return NULL;
 
 	struct lif_state_record *rec = entry->data;
-	struct lif_dict_entry *if_entry = lif_dict_find(if_collection, rec->mapped_if);
 
-	if (if_entry == NULL)
+	if (!rec->refcount)
 		return NULL;
 
-	return if_entry->data;
+	return lif_interface_collection_lookup(if_collection, rec->mapped_if);
 }
 
 bool
@@ -179,10 +1041,17 @@ lif_state_sync(struct lif_dict *state, struct lif_dict *if_collection)
 	{
 		struct lif_dict_entry *entry = iter->data;
 		struct lif_state_record *rec = entry->data;
+
+		if (!rec->refcount)
+			continue;
+
 		struct lif_interface *iface = lif_interface_collection_find(if_collection, rec->mapped_if);
+		if (iface == NULL)
+			return false;
 
 		iface->refcount = rec->refcount;
 		iface->is_explicit = rec->is_explicit;
+		iface->fingerprint = rec->fingerprint;
 	}
 
 	return true;
@@ -18,23 +18,35 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "libifupdown/interface.h"
 
+/*
+ * Records remember the refcount they were read with, and whether they have
+ * been changed since, so that writing the state only applies the changes
+ * of this process on top of what the file holds by then.  A record which
+ * is deleted stays behind with a refcount of 0 until the state is written.
+ */
 struct lif_state_record {
 	char *mapped_if;
 	size_t refcount;
 
 	bool is_explicit;
+	uint64_t fingerprint;
+
+	size_t base_refcount;
+	bool changed;
 };
 
 extern bool lif_state_read(struct lif_dict *state, FILE *f);
 extern bool lif_state_read_path(struct lif_dict *state, const char *path);
-extern void lif_state_upsert(struct lif_dict *state, const char *ifname, struct lif_interface *iface);
-extern void lif_state_ref_if(struct lif_dict *state, const char *ifname, struct lif_interface *iface);
-extern void lif_state_unref_if(struct lif_dict *state, const char *ifname, struct lif_interface *iface);
+extern bool lif_state_can_record(const char *path, const char *ifname, const char *mapped_if);
+extern bool lif_state_upsert(struct lif_dict *state, const char *ifname, struct lif_interface *iface);
+extern bool lif_state_ref_if(struct lif_dict *state, const char *ifname, struct lif_interface *iface);
+extern bool lif_state_unref_if(struct lif_dict *state, const char *ifname, struct lif_interface *iface);
 extern void lif_state_delete(struct lif_dict *state, const char *ifname);
 extern void lif_state_write(const struct lif_dict *state, FILE *f);
-extern bool lif_state_write_path(const struct lif_dict *state, const char *path);
+extern bool lif_state_write_path(struct lif_dict *state, const char *path);
 extern struct lif_interface *lif_state_lookup(struct lif_dict *state, struct lif_dict *if_collection, const char *ifname);
 extern bool lif_state_sync(struct lif_dict *state, struct lif_dict *if_collection);
 
@@ -0,0 +1,135 @@
+/*
+ * libifupdown/symbol.c
+ * Purpose: interned strings used as dictionary keys
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libifupdown/symbol.h"
+
+#define LIF_SYMBOL_TABLE_MIN_SIZE	256
+
+struct symbol_slot {
+	const char *str;
+	unsigned int hash;
+};
+
+static struct symbol_slot *symbols = NULL;
+static size_t symbols_size = 0;
+static size_t symbols_count = 0;
+
+static unsigned int
+symbol_hash(const char *str)
+{
+	unsigned int hash = 2166136261u;
+
+	for (; *str; str++)
+	{
+		hash ^= (unsigned char) *str;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static struct symbol_slot *
+symbol_slot(const char *str, unsigned int hash)
+{
+	size_t mask = symbols_size - 1;
+	size_t slot = hash & mask;
+
+	while (symbols[slot].str != NULL)
+	{
+		if (symbols[slot].hash == hash && !strcmp(symbols[slot].str, str))
+			break;
+
+		slot = (slot + 1) & mask;
+	}
+
+	return &symbols[slot];
+}
+
+static bool
+symbol_table_grow(void)
+{
+	struct symbol_slot *old_symbols = symbols;
+	size_t old_size = symbols_size;
+	size_t size = old_size ? old_size * 2 : LIF_SYMBOL_TABLE_MIN_SIZE;
+
+	struct symbol_slot *new_symbols = calloc(size, sizeof *new_symbols);
+	if (new_symbols == NULL)
+		return false;
+
+	symbols = new_symbols;
+	symbols_size = size;
+
+	for (size_t i = 0; i < old_size; i++)
+	{
+		if (old_symbols[i].str != NULL)
+			*symbol_slot(old_symbols[i].str, old_symbols[i].hash) = old_symbols[i];
+	}
+
+	free(old_symbols);
+	return true;
+}
+
+static const char *
+symbol_insert(const char *str, bool copy)
+{
+	unsigned int hash = symbol_hash(str);
+
+	if (symbols_size)
+	{
+		struct symbol_slot *slot = symbol_slot(str, hash);
+
+		if (slot->str != NULL)
+			return slot->str;
+	}
+
+	/* keep the load factor at or below one half */
+	if ((symbols_count + 1) * 2 > symbols_size && !symbol_table_grow())
+		return NULL;
+
+	const char *sym = copy ? strdup(str) : str;
+	if (sym == NULL)
+		return NULL;
+
+	struct symbol_slot *slot = symbol_slot(str, hash);
+	slot->str = sym;
+	slot->hash = hash;
+	symbols_count++;
+
+	return sym;
+}
+
+const char *
+lif_symbol_intern(const char *str)
+{
+	return symbol_insert(str, true);
+}
+
+const char *
+lif_symbol_register(const char *str)
+{
+	return symbol_insert(str, false);
+}
+
+const char *
+lif_symbol_find(const char *str)
+{
+	if (!symbols_size)
+		return NULL;
+
+	return symbol_slot(str, symbol_hash(str))->str;
+}
@@ -0,0 +1,34 @@
+/*
+ * libifupdown/symbol.h
+ * Purpose: interned strings used as dictionary keys
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#ifndef LIBIFUPDOWN_SYMBOL_H__GUARD
+#define LIBIFUPDOWN_SYMBOL_H__GUARD
+
+/*
+ * A symbol is the canonical copy of a string: interning equal strings
+ * always yields the same pointer, so symbols may be compared with ==.
+ * Symbols live until the process exits.
+ */
+
+/* returns the symbol for str, creating it if needed */
+extern const char *lif_symbol_intern(const char *str);
+
+/* returns the symbol for str, or NULL if str was never interned */
+extern const char *lif_symbol_find(const char *str);
+
+/* makes a string with static storage the symbol for its contents, if there is none yet */
+extern const char *lif_symbol_register(const char *str);
+
+#endif
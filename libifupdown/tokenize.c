@@ -0,0 +1,178 @@
+/*
+ * libifupdown/tokenize.c
+ * Purpose: tokenization helper
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#include <stdint.h>
+#include "libifupdown/tokenize.h"
+
+/*
+ * Separators are the bytes isspace() accepts in the C locale, and '='
+ * when tokenizing key=value pairs.  The vector versions classify 16 bytes
+ * at a time, using aligned loads so that they never read across a page
+ * boundary past the terminating NUL.  Build with -DLIF_TOKENIZE_SCALAR to
+ * use the byte at a time version everywhere.
+ */
+#if !defined(LIF_TOKENIZE_SCALAR) && defined(__SSE2__)
+# include <emmintrin.h>
+# define LIF_TOKENIZE_SSE2
+#elif !defined(LIF_TOKENIZE_SCALAR) && defined(__ARM_NEON) && defined(__aarch64__)
+# include <arm_neon.h>
+# define LIF_TOKENIZE_NEON
+#endif
+
+#if defined(LIF_TOKENIZE_SSE2)
+
+#define BLOCK_SIZE	16
+#define MASK_BITS	1		/* bits per byte in a block mask */
+#define BLOCK_MASK	UINT64_C(0xffff)
+
+typedef __m128i block_t;
+
+static inline block_t
+load_block(const char *p)
+{
+	return _mm_load_si128((const __m128i *)(const void *) p);
+}
+
+static inline uint64_t
+separator_mask(block_t v, bool eq)
+{
+	/* \t to \r are matched with an unsigned range check: v - '\t' <= '\r' - '\t' */
+	__m128i ctl = _mm_sub_epi8(v, _mm_set1_epi8('\t'));
+	__m128i sep = _mm_cmpeq_epi8(_mm_min_epu8(ctl, _mm_set1_epi8('\r' - '\t')), ctl);
+
+	sep = _mm_or_si128(sep, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+	if (eq)
+		sep = _mm_or_si128(sep, _mm_cmpeq_epi8(v, _mm_set1_epi8('=')));
+
+	return (unsigned) _mm_movemask_epi8(sep);
+}
+
+static inline uint64_t
+nul_mask(block_t v)
+{
+	return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128()));
+}
+
+#elif defined(LIF_TOKENIZE_NEON)
+
+#define BLOCK_SIZE	16
+#define MASK_BITS	4
+#define BLOCK_MASK	(~UINT64_C(0))
+
+typedef uint8x16_t block_t;
+
+static inline block_t
+load_block(const char *p)
+{
+	return vld1q_u8((const uint8_t *) p);
+}
+
+/* NEON has no movemask: narrowing each 16-bit lane by 4 bits leaves a nibble per byte */
+static inline uint64_t
+to_mask(uint8x16_t v)
+{
+	return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+
+static inline uint64_t
+separator_mask(block_t v, bool eq)
+{
+	uint8x16_t sep = vcleq_u8(vsubq_u8(v, vdupq_n_u8('\t')), vdupq_n_u8('\r' - '\t'));
+
+	sep = vorrq_u8(sep, vceqq_u8(v, vdupq_n_u8(' ')));
+	if (eq)
+		sep = vorrq_u8(sep, vceqq_u8(v, vdupq_n_u8('=')));
+
+	return to_mask(sep);
+}
+
+static inline uint64_t
+nul_mask(block_t v)
+{
+	return to_mask(vceqzq_u8(v));
+}
+
+#endif
+
+#ifdef BLOCK_SIZE
+
+/* bits of a block mask which belong to the bytes from p onwards */
+static inline uint64_t
+leading_mask(const char *block, const char *p)
+{
+	return BLOCK_MASK & (BLOCK_MASK << ((p - block) * MASK_BITS));
+}
+
+char *
+lif_token_skip_separators(const char *p, bool eq)
+{
+	const char *block = (const char *)((uintptr_t) p & ~(uintptr_t) (BLOCK_SIZE - 1));
+
+	/* the terminating NUL is not a separator, so it ends the scan as well */
+	uint64_t mask = ~separator_mask(load_block(block), eq) & leading_mask(block, p);
+
+	while (!mask)
+	{
+		block += BLOCK_SIZE;
+		mask = ~separator_mask(load_block(block), eq) & BLOCK_MASK;
+	}
+
+	return (char *) block + __builtin_ctzll(mask) / MASK_BITS;
+}
+
+char *
+lif_token_find_end(const char *p, bool eq)
+{
+	const char *block = (const char *)((uintptr_t) p & ~(uintptr_t) (BLOCK_SIZE - 1));
+	block_t v = load_block(block);
+	uint64_t mask = (separator_mask(v, eq) | nul_mask(v)) & leading_mask(block, p);
+
+	while (!mask)
+	{
+		block += BLOCK_SIZE;
+		v = load_block(block);
+		mask = separator_mask(v, eq) | nul_mask(v);
+	}
+
+	return (char *) block + __builtin_ctzll(mask) / MASK_BITS;
+}
+
+#else
+
+static inline bool
+is_separator(unsigned char c, bool eq)
+{
+	return c == ' ' || (c >= '\t' && c <= '\r') || (eq && c == '=');
+}
+
+char *
+lif_token_skip_separators(const char *p, bool eq)
+{
+	while (*p && is_separator(*p, eq))
+		p++;
+
+	return (char *) p;
+}
+
+char *
+lif_token_find_end(const char *p, bool eq)
+{
+	while (*p && !is_separator(*p, eq))
+		p++;
+
+	return (char *) p;
+}
+
+#endif
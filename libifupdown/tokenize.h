@@ -16,21 +16,22 @@
 #ifndef LIBIFUPDOWN_TOKENIZE_H__GUARD
 #define LIBIFUPDOWN_TOKENIZE_H__GUARD
 
-#include <ctype.h>
+#include <stdbool.h>
+
+/* both return a pointer to the terminating NUL if they reach it */
+extern char *lif_token_skip_separators(const char *p, bool eq);
+extern char *lif_token_find_end(const char *p, bool eq);
 
 static inline char *
 lif_next_token_eq(char **buf)
 {
-	char *out = *buf;
-
-	while (*out && (isspace(*out) || *out == '='))
-		out++;
+	char *out = lif_token_skip_separators(*buf, true);
+	char *end = lif_token_find_end(out, true);
 
-	char *end = out;
-	while (*end && !isspace(*end) && *end != '=')
-		end++;
+	/* never step past the end of the line, it may be followed by the next one */
+	if (*end)
+		*end++ = '\0';
 
-	*end++ = '\0';
 	*buf = end;
 
 	return out;
@@ -39,16 +40,13 @@ lif_next_token_eq(char **buf)
 static inline char *
 lif_next_token(char **buf)
 {
-	char *out = *buf;
-
-	while (*out && isspace(*out))
-		out++;
+	char *out = lif_token_skip_separators(*buf, false);
+	char *end = lif_token_find_end(out, false);
 
-	char *end = out;
-	while (*end && !isspace(*end))
-		end++;
+	/* never step past the end of the line, it may be followed by the next one */
+	if (*end)
+		*end++ = '\0';
 
-	*end++ = '\0';
 	*buf = end;
 
 	return out;
@@ -0,0 +1,216 @@
+/*
+ * libifupdown/value.c
+ * Purpose: typed configuration values
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libifupdown/value.h"
+#include "libifupdown/symbol.h"
+
+struct value_key {
+	const char *key;
+	enum lif_value_type type;
+	long long min, max;	/* range of LIF_VALUE_INTEGER values */
+};
+
+/* timeouts are handled in milliseconds internally */
+#define TIMEOUT_MAX	(INT_MAX / 1000)
+
+static const struct value_key value_keys[] = {
+	{"ipv6-dad-wait", LIF_VALUE_INTEGER, 0, TIMEOUT_MAX},
+	{"ipv6-optimistic-dad", LIF_VALUE_BOOL, 0, 0},
+	{"metric", LIF_VALUE_INTEGER, 0, UINT32_MAX},
+	{"mtu", LIF_VALUE_INTEGER, 0, UINT32_MAX},
+	{"netmask", LIF_VALUE_NETMASK, 0, 0},
+	{"vrf-table", LIF_VALUE_INTEGER, 0, UINT32_MAX},
+	{"wait-carrier", LIF_VALUE_INTEGER, 0, TIMEOUT_MAX},
+};
+
+#define VALUE_KEY_COUNT (sizeof value_keys / sizeof *value_keys)
+
+static const struct value_key *
+value_key_find(const char *key)
+{
+	static const char *symbols[VALUE_KEY_COUNT];
+
+	if (symbols[0] == NULL)
+	{
+		for (size_t i = 0; i < VALUE_KEY_COUNT; i++)
+			symbols[i] = lif_symbol_intern(value_keys[i].key);
+	}
+
+	/* keys are symbols, but accept any string naming one */
+	key = lif_symbol_find(key);
+	if (key == NULL)
+		return NULL;
+
+	for (size_t i = 0; i < VALUE_KEY_COUNT; i++)
+	{
+		if (symbols[i] == key)
+			return &value_keys[i];
+	}
+
+	return NULL;
+}
+
+enum lif_value_type
+lif_value_type_of(const char *key)
+{
+	const struct value_key *vk = value_key_find(key);
+
+	return vk != NULL ? vk->type : LIF_VALUE_STRING;
+}
+
+static bool
+parse_bool(struct lif_value *value, const char *text)
+{
+	/* the spellings understood by the executors */
+	if (!strcmp(text, "yes") || !strcmp(text, "1"))
+		value->boolean = true;
+	else if (!strcmp(text, "no") || !strcmp(text, "0"))
+		value->boolean = false;
+	else
+		return false;
+
+	return true;
+}
+
+static bool
+parse_integer(struct lif_value *value, const struct value_key *vk, const char *text)
+{
+	char *end;
+	long long integer = strtoll(text, &end, 10);
+
+	if (!*text || *end || integer < vk->min || integer > vk->max)
+		return false;
+
+	value->integer = integer;
+	return true;
+}
+
+static bool
+parse_netmask(struct lif_value *value, const char *text)
+{
+	/* netmask set to CIDR length */
+	if (strchr(text, '.') == NULL)
+	{
+		char *end;
+		long prefixlen = strtol(text, &end, 10);
+
+		if (!*text || *end || prefixlen < 0 || prefixlen > 128)
+			return false;
+
+		value->netmask = prefixlen;
+		return true;
+	}
+
+	struct in_addr in;
+
+	if (inet_pton(AF_INET, text, &in) != 1)
+		return false;
+
+	/* the set bits of a netmask must be contiguous */
+	uint32_t bits = ntohl(in.s_addr);
+	uint32_t inverted = ~bits;
+
+	if (inverted & (inverted + 1))
+		return false;
+
+	size_t prefixlen = 0;
+	for (; bits; bits <<= 1)
+		prefixlen++;
+
+	value->netmask = prefixlen;
+	return true;
+}
+
+/*
+ * Parse text as the value of a typed key, allocating from the dictionary
+ * it is going to be stored in.  Returns NULL and sets errstr if the text
+ * is not valid for the type of the key.
+ */
+struct lif_value *
+lif_value_parse(const struct lif_dict *dict, const char *key, const char *text, const char **errstr)
+{
+	const struct value_key *vk = value_key_find(key);
+	size_t len = strlen(text);
+
+	/* trailing whitespace is not part of a typed value */
+	while (len && isspace((unsigned char) text[len - 1]))
+		len--;
+
+	struct lif_value *value = lif_dict_alloc(dict, sizeof *value + len + 1);
+	if (value == NULL)
+	{
+		*errstr = "out of memory";
+		return NULL;
+	}
+
+	value->type = vk != NULL ? vk->type : LIF_VALUE_STRING;
+	memcpy(value->text, text, len);
+	value->text[len] = '\0';
+
+	bool ok = true;
+
+	switch (value->type)
+	{
+	case LIF_VALUE_STRING:
+		break;
+	case LIF_VALUE_BOOL:
+		ok = parse_bool(value, value->text);
+		*errstr = "yes or no expected";
+		break;
+	case LIF_VALUE_INTEGER:
+		ok = parse_integer(value, vk, value->text);
+		*errstr = "number expected, or out of range";
+		break;
+	case LIF_VALUE_NETMASK:
+		ok = parse_netmask(value, value->text);
+		*errstr = "netmask or prefix length expected";
+		break;
+	}
+
+	if (!ok)
+	{
+		lif_dict_free(dict, value);
+		return NULL;
+	}
+
+	return value;
+}
+
+/* returns the text of a variable as configured, whether or not it has a type */
+const char *
+lif_value_text(const struct lif_dict_entry *entry)
+{
+	if (lif_value_type_of(entry->key) == LIF_VALUE_STRING)
+		return entry->data;
+
+	const struct lif_value *value = entry->data;
+	return value->text;
+}
+
+/* returns the parsed value of a variable, if it is of the given type */
+const struct lif_value *
+lif_value_get(const struct lif_dict_entry *entry, enum lif_value_type type)
+{
+	if (entry == NULL || type == LIF_VALUE_STRING || lif_value_type_of(entry->key) != type)
+		return NULL;
+
+	return entry->data;
+}
@@ -0,0 +1,56 @@
+/*
+ * libifupdown/value.h
+ * Purpose: typed configuration values
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+#ifndef LIBIFUPDOWN_VALUE_H__GUARD
+#define LIBIFUPDOWN_VALUE_H__GUARD
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "libifupdown/dict.h"
+
+/*
+ * Most configuration variables are stored as strings.  Variables which
+ * have a known type are parsed and validated once, when the configuration
+ * is loaded, and stored as a `struct lif_value`, which keeps the text as
+ * configured for executors next to the parsed value.
+ *
+ * Addresses are stored as `struct lif_address` instead, and the interfaces
+ * named by requires are resolved by lif_interface_resolve_requires().
+ */
+enum lif_value_type {
+	LIF_VALUE_STRING,
+	LIF_VALUE_BOOL,
+	LIF_VALUE_INTEGER,
+	LIF_VALUE_NETMASK,
+};
+
+struct lif_value {
+	enum lif_value_type type;
+
+	union {
+		bool boolean;
+		long long integer;
+		size_t netmask;		/* prefix length */
+	};
+
+	char text[];
+};
+
+extern enum lif_value_type lif_value_type_of(const char *key);
+extern struct lif_value *lif_value_parse(const struct lif_dict *dict, const char *key, const char *text, const char **errstr);
+extern const char *lif_value_text(const struct lif_dict_entry *entry);
+extern const struct lif_value *lif_value_get(const struct lif_dict_entry *entry, enum lif_value_type type);
+
+#endif
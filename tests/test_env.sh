@@ -3,6 +3,14 @@ FIXTURES="$(atf_get_srcdir)/fixtures"
 EXECUTORS="$(atf_get_srcdir)/executors"
 EXECUTORS_LINUX="$(atf_get_srcdir)/../executor-scripts/linux"
 
+# never read or write the host's snapshot, tests which want one pass -C
+IFUPDOWN_NG_SNAPSHOT_FILE=""
+export IFUPDOWN_NG_SNAPSHOT_FILE
+
+# nor its configuration, tests which want one point this at their own
+IFUPDOWN_NG_CONFIG=/dev/null
+export IFUPDOWN_NG_CONFIG
+
 tests_init() {
 	TESTS="$@"
 	export TESTS
@@ -0,0 +1,236 @@
+/*
+ * tools/perfect-hash.c
+ * Purpose: generate perfect hash tables at build time
+ *
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * This software is provided 'as is' and without any warranty, express or
+ * implied.  In no event shall the authors be liable for any damages arising
+ * from the use of this software.
+ */
+
+/*
+ * The input holds one or more tables:
+ *
+ *	%table <type> <name>
+ *	<key>	<initializers>	<optional C comment>
+ *
+ * and lines starting with # are ignored.  For every table, an array
+ * `static const <type> <name>[]` of `{"<key>", <initializers>}` entries is
+ * written, in input order, along with a `struct lif_perfect_hash
+ * <name>_hash` to look the entries up by key.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libifupdown/perfect-hash.h"
+
+#define MAX_ENTRIES	4096
+#define MAX_SEEDS	1000000
+
+struct entry {
+	char *key;
+	char *init;
+	char *comment;
+};
+
+struct table {
+	char *type;
+	char *name;
+	struct entry entries[MAX_ENTRIES];
+	size_t count;
+};
+
+static const char *input_name;
+static size_t lineno;
+
+static void
+die(const char *msg, const char *arg)
+{
+	fprintf(stderr, "%s:%zu: %s%s\n", input_name, lineno, msg, arg);
+	exit(EXIT_FAILURE);
+}
+
+static char *
+trim(char *s)
+{
+	while (*s == ' ' || *s == '\t')
+		s++;
+
+	char *end = s + strlen(s);
+	while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n'))
+		*--end = '\0';
+
+	return s;
+}
+
+static bool
+try_seed(const struct table *table, uint32_t seed, uint32_t mask, uint16_t *slots)
+{
+	memset(slots, 0, (mask + 1) * sizeof *slots);
+
+	for (size_t i = 0; i < table->count; i++)
+	{
+		uint32_t slot = lif_perfect_hash_key(table->entries[i].key, seed) & mask;
+
+		if (slots[slot])
+			return false;
+
+		slots[slot] = i + 1;
+	}
+
+	return true;
+}
+
+static void
+write_table(const struct table *table)
+{
+	uint32_t mask = 1;
+	uint32_t seed = 0;
+	uint16_t *slots = NULL;
+
+	if (table == NULL)
+		return;
+
+	for (size_t i = 0; i < table->count; i++)
+		for (size_t j = i + 1; j < table->count; j++)
+			if (!strcmp(table->entries[i].key, table->entries[j].key))
+				die("duplicate key ", table->entries[i].key);
+
+	/* start with twice as many slots as entries, and grow until a seed works */
+	while (mask + 1 < 2 * table->count)
+		mask = (mask << 1) | 1;
+
+	for (;;)
+	{
+		slots = realloc(slots, (mask + 1) * sizeof *slots);
+		if (slots == NULL)
+			die("out of memory", "");
+
+		for (seed = 0; seed < MAX_SEEDS; seed++)
+			if (try_seed(table, seed, mask, slots))
+				goto found;
+
+		mask = (mask << 1) | 1;
+	}
+
+found:
+	printf("static const %s %s[] = {\n", table->type, table->name);
+	for (size_t i = 0; i < table->count; i++)
+	{
+		const struct entry *entry = &table->entries[i];
+
+		printf("\t{\"%s\", %s},", entry->key, entry->init);
+		if (*entry->comment)
+			printf("\t%s", entry->comment);
+		printf("\n");
+	}
+	printf("};\n\n");
+
+	printf("static const uint16_t %s_hash_slots[%u] = {", table->name, mask + 1);
+	for (uint32_t i = 0; i <= mask; i++)
+		printf("%s%u,", i % 16 ? " " : "\n\t", slots[i]);
+	printf("\n};\n\n");
+
+	printf("static const struct lif_perfect_hash %s_hash = {\n", table->name);
+	printf("\t.seed = %uu,\n", seed);
+	printf("\t.mask = %u,\n", mask);
+	printf("\t.slots = %s_hash_slots,\n", table->name);
+	printf("};\n\n");
+
+	free(slots);
+}
+
+int
+main(int argc, char *argv[])
+{
+	static struct table table;
+	struct table *cur = NULL;
+	char line[4096];
+
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: %s <input>\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	input_name = argv[1];
+
+	FILE *f = fopen(input_name, "r");
+	if (f == NULL)
+	{
+		perror(input_name);
+		return EXIT_FAILURE;
+	}
+
+	printf("/* generated from %s by tools/perfect-hash, do not edit */\n\n", input_name);
+	printf("#include <stdint.h>\n");
+	printf("#include \"libifupdown/perfect-hash.h\"\n\n");
+
+	while (fgets(line, sizeof line, f) != NULL)
+	{
+		lineno++;
+
+		char *p = trim(line);
+		if (!*p || *p == '#')
+			continue;
+
+		if (!strncmp(p, "%table", 6))
+		{
+			write_table(cur);
+
+			char *name = strrchr(p, ' ');
+			if (name == NULL)
+				die("missing table name", "");
+
+			*name++ = '\0';
+
+			/* the strings of the previous table are not freed, this runs once per build */
+			memset(&table, 0, sizeof table);
+			table.type = strdup(trim(p + 6));
+			table.name = strdup(name);
+			cur = &table;
+			continue;
+		}
+
+		if (cur == NULL)
+			die("entry outside of a table", "");
+
+		if (cur->count == MAX_ENTRIES)
+			die("too many entries in table ", cur->name);
+
+		char *key = strdup(p);
+		char *init = key + strcspn(key, " \t");
+		if (!*init)
+			die("missing initializers for ", key);
+
+		*init++ = '\0';
+
+		char *comment = strstr(init, "/*");
+		if (comment != NULL)
+		{
+			char *start = comment;
+
+			comment = strdup(comment);
+			*start = '\0';
+		}
+
+		cur->entries[cur->count++] = (struct entry) {
+			.key = key,
+			.init = trim(init),
+			.comment = comment != NULL ? comment : "",
+		};
+	}
+
+	write_table(cur);
+	fclose(f);
+
+	return ferror(stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+}